@@ -6,6 +6,14 @@
 #include <mpi.h>
 #include <cilk/cilk_api.h>
 #include <string.h>
+#include <strings.h>
+#include <sys/resource.h>
+#include <errno.h>
+#include <unistd.h>
+#include <stdint.h>
+#include "ccperf.h"
+
+#define LABELS_MAGIC "CCL1"
 
 typedef struct Graph {
     int vertices;
@@ -15,6 +23,73 @@ typedef struct Graph {
     int *labels;
 } Graph;
 
+typedef struct Components { // Per-vertex compacted component ids and per-component sizes
+    int count;
+    int *comp;
+    int *roots;
+    int *sizes;
+} Components;
+
+#ifdef CC_TRACE
+// Instrumented build (make TRACE=1): rank 0 writes <file.mtx>.trace.json with phase timings, peak RSS and,
+// per iteration, wall time, labels changed, edges scanned and every rank's compute time (the rest is
+// communication and waiting). In normal builds every TRACE() statement compiles away.
+#define TRACE(...) __VA_ARGS__
+enum { PHASE_PARSE, PHASE_CSR_BUILD, PHASE_BROADCAST, PHASE_COMPUTE, PHASE_STATS, NUM_PHASES };
+const char* phase_names[NUM_PHASES] = {"parse", "csr_build", "broadcast", "compute", "stats"};
+typedef struct TraceIteration { double time; long long changed, edges; double *busy; } TraceIteration;
+typedef struct Trace { double phase[NUM_PHASES]; TraceIteration *iters; int count, cap, ranks; } Trace;
+Trace trace = {{0}, NULL, 0, 0, 1};
+
+double traceTime() { struct timespec t; clock_gettime(CLOCK_MONOTONIC, &t); return t.tv_sec + t.tv_nsec / 1e9; }
+
+TraceIteration* traceIteration() {
+    if (trace.count == trace.cap) {
+        trace.cap = trace.cap ? 2 * trace.cap : 64;
+        trace.iters = realloc(trace.iters, trace.cap * sizeof(TraceIteration));
+    }
+    TraceIteration *it = &trace.iters[trace.count++];
+    it->time = 0; it->changed = 0; it->edges = 0;
+    it->busy = calloc(trace.ranks, sizeof(double));
+    return it;
+}
+
+void traceWrite(const char* filename, long long vertices, long long edges) {
+    char name[512]; snprintf(name, sizeof(name), "%s.trace.json", filename);
+    FILE* f = fopen(name, "w");
+    if (!f) { fprintf(stderr, "[Rank 0] Failed to write %s\n", name); return; }
+    struct rusage usage; getrusage(RUSAGE_SELF, &usage);
+    fprintf(f, "{\n  \"backend\": \"mpi\", \"graph\": \"%s\", \"vertices\": %lld, \"edges\": %lld, \"ranks\": %d, \"workers_per_rank\": %d,\n",
+            filename, vertices, edges, trace.ranks, __cilkrts_get_nworkers());
+    fprintf(f, "  \"peak_rss_mb\": %.2f,\n  \"phases\": {", usage.ru_maxrss / 1024.0);
+    for (int i = 0; i < NUM_PHASES; i++) fprintf(f, "%s\"%s\": %f", i ? ", " : "", phase_names[i], trace.phase[i]);
+    fprintf(f, "},\n  \"iterations\": [");
+    for (int i = 0; i < trace.count; i++) {
+        TraceIteration *it = &trace.iters[i];
+        fprintf(f, "%s\n    {\"time\": %f, \"changed\": %lld, \"edges_scanned\": %lld, \"edges_per_sec\": %.0f, \"busy\": [",
+                i ? "," : "", it->time, it->changed, it->edges, it->time > 0 ? it->edges / it->time : 0.0);
+        for (int r = 0; r < trace.ranks; r++) fprintf(f, "%s%f", r ? ", " : "", it->busy[r]);
+        fprintf(f, "], \"idle\": [");
+        for (int r = 0; r < trace.ranks; r++) fprintf(f, "%s%f", r ? ", " : "", it->time > it->busy[r] ? it->time - it->busy[r] : 0.0);
+        fprintf(f, "]}");
+    }
+    fprintf(f, "\n  ]\n}\n");
+    fclose(f);
+    printf("Saved trace file: %s\n", name);
+}
+#else
+#define TRACE(...)
+#endif
+
+// Hardware counters (--perf, --perf-iter) come from the shared ccperf.c: every rank opens a counter set per
+// thread alive after the Cilk workers start, samples are summed over ranks and printed by rank 0.
+void perfCombine(double *values, int count, bool min) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    if (min) MPI_Allreduce(MPI_IN_PLACE, values, count, MPI_DOUBLE, MPI_MIN, MPI_COMM_WORLD);
+    else MPI_Reduce(rank == 0 ? MPI_IN_PLACE : values, values, count, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+}
+
 void* safe_malloc(size_t size, const char* name, int rank) {
     void* ptr = malloc(size);
     if (!ptr && size > 0) {
@@ -74,11 +149,21 @@ void BroadcastGraph(Graph** g_ptr, int rank) {
     }
 }
 
+int compareInt(const void *a, const void *b) {
+    int x = *(const int*)a, y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
 Graph *readMTX(const char* filename, int rank) {
     FILE* f = fopen(filename, "r");
     if (!f) return NULL;
-    char line[1024];
-    while (fgets(line, sizeof(line), f) && (line[0] == '%' || line[0] == '#'));
+    char line[1024], format[64] = "coordinate", symmetry[64] = "general";
+    while (fgets(line, sizeof(line), f) && (line[0] == '%' || line[0] == '#'))
+        if (strncasecmp(line, "%%MatrixMarket", 14) == 0) sscanf(line + 14, "%*s %63s %*s %63s", format, symmetry);
+    if (strcasecmp(format, "coordinate") != 0) {
+        printf("Only coordinate MatrixMarket files are supported, %s is %s\n", filename, format);
+        fclose(f); return NULL;
+    }
 
     int rows, cols;
     long long nnz;
@@ -89,6 +174,7 @@ Graph *readMTX(const char* filename, int rank) {
     long long *temp_count = calloc(n, sizeof(long long)); // Use 64-bit counts
     
     // Pass 1: Count degrees (Handles SuiteSparse weights automatically)
+    TRACE(double parse_start = traceTime());
     int u, v;
     for (long long i = 0; i < nnz; i++) {
         if (fscanf(f, "%d %d%*[^\n]", &u, &v) == 2) {
@@ -98,6 +184,7 @@ Graph *readMTX(const char* filename, int rank) {
             }
         }
     }
+    TRACE(trace.phase[PHASE_PARSE] = traceTime() - parse_start);
     g->offsets[0] = 0;
     for (int i = 0; i < n; i++) g->offsets[i+1] = g->offsets[i] + temp_count[i];
     g->num_edges = g->offsets[n];
@@ -106,8 +193,7 @@ Graph *readMTX(const char* filename, int rank) {
     // Pass 2: Fill edges
     memset(temp_count, 0, (size_t)n * sizeof(long long));
     rewind(f);
-    while (fgets(line, sizeof(line), f) && (line[0] == '%' || line[0] == '#'));
-    fgets(line, sizeof(line), f); // skip header
+    while (fgets(line, sizeof(line), f) && (line[0] == '%' || line[0] == '#')); // stops after the header line
     for (long long i = 0; i < nnz; i++) {
         if (fscanf(f, "%d %d%*[^\n]", &u, &v) == 2) {
             u--; v--;
@@ -117,11 +203,30 @@ Graph *readMTX(const char* filename, int rank) {
             }
         }
     }
-    free(temp_count); fclose(f);
+    fclose(f);
+
+    // Sort and deduplicate every list (general-format files list both directions), then pack them left
+    long long before = g->num_edges, w = 0;
+    cilk_for (int v = 0; v < n; v++) {
+        int *list = g->edges + g->offsets[v];
+        long long deg = g->offsets[v+1] - g->offsets[v], unique = (deg > 0) ? 1 : 0;
+        if (deg > 1) qsort(list, deg, sizeof(int), compareInt);
+        for (long long k = 1; k < deg; k++) if (list[k] != list[unique-1]) list[unique++] = list[k];
+        temp_count[v] = unique;
+    }
+    for (int v = 0; v < n; v++) {
+        memmove(g->edges + w, g->edges + g->offsets[v], (size_t)temp_count[v] * sizeof(int));
+        g->offsets[v] = w; w += temp_count[v];
+    }
+    g->offsets[n] = g->num_edges = w;
+    free(temp_count);
+    TRACE(trace.phase[PHASE_CSR_BUILD] = traceTime() - parse_start - trace.phase[PHASE_PARSE]);
+    printf("MatrixMarket %s %s: %lld duplicate directed edges removed\n", format, symmetry, before - w);
     return g;
 }
 
-void ColoringAlgorithmHybrid(Graph* g, int rank, int size) {
+// Returns the number of global sweeps until no rank changed a label
+int ColoringAlgorithmHybrid(Graph* g, int rank, int size) {
     int n = g->vertices;
     int chunk = n / size;
     int start_v = rank * chunk;
@@ -136,22 +241,113 @@ void ColoringAlgorithmHybrid(Graph* g, int rank, int size) {
         displs[i] = r_start;
     }
 
-    int global_changed = 1;
+    int global_changed = 1, iterations = 0;
     while (global_changed) {
         int local_changed = 0;
+        iterations++;
+        TRACE(TraceIteration *it = traceIteration(); double it_start = traceTime(); long long local_count = 0);
         cilk_for(int v = start_v; v < end_v; v++) {
             for (long long k = g->offsets[v]; k < g->offsets[v+1]; k++) {
                 int u = g->edges[k];
                 if (g->labels[v] > g->labels[u]) {
                     g->labels[v] = g->labels[u];
                     local_changed = 1; 
+                    TRACE(__atomic_fetch_add(&local_count, 1, __ATOMIC_RELAXED));
                 }
             }
         }
+        TRACE(double busy = traceTime() - it_start);
         MPI_Allgatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL, g->labels, recvcounts, displs, MPI_INT, MPI_COMM_WORLD);
         MPI_Allreduce(&local_changed, &global_changed, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+        TRACE(it->time = traceTime() - it_start; it->edges = g->num_edges);
+        TRACE(MPI_Reduce(&local_count, &it->changed, 1, MPI_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD));
+        TRACE(MPI_Gather(&busy, 1, MPI_DOUBLE, it->busy, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD));
+        if (perf.per_iteration) perfSample("iteration", iterations, (double)g->num_edges);
     }
     free(recvcounts); free(displs);
+    return iterations;
+}
+
+// Compact labels into 0..count-1 and count component sizes with one histogram per Cilk worker
+Components* computeComponents(Graph* g, int rank) {
+    int n = g->vertices;
+    int *labels = g->labels;
+    int chunks = __cilkrts_get_nworkers();
+    Components* c = safe_malloc(sizeof(Components), "Components", rank);
+    int *root_count = calloc(chunks + 1, sizeof(int));
+    int **hists = safe_malloc(chunks * sizeof(int*), "Histograms", rank);
+    c->comp = safe_malloc((size_t)n * sizeof(int), "Component ids", rank);
+
+    cilk_for(int t = 0; t < chunks; t++) {
+        int lo = (long long)n * t / chunks, hi = (long long)n * (t + 1) / chunks, local = 0;
+        for (int v = lo; v < hi; v++) if (labels[v] == v) local++;
+        root_count[t + 1] = local;
+    }
+    for (int i = 1; i <= chunks; i++) root_count[i] += root_count[i - 1];
+    c->count = root_count[chunks];
+    c->roots = safe_malloc((size_t)c->count * sizeof(int), "Roots", rank);
+    c->sizes = safe_malloc((size_t)c->count * sizeof(int), "Sizes", rank);
+
+    cilk_for(int t = 0; t < chunks; t++) {
+        int lo = (long long)n * t / chunks, hi = (long long)n * (t + 1) / chunks, id = root_count[t];
+        for (int v = lo; v < hi; v++) if (labels[v] == v) { c->comp[v] = id; c->roots[id++] = v; }
+    }
+    cilk_for(int t = 0; t < chunks; t++) {
+        int lo = (long long)n * t / chunks, hi = (long long)n * (t + 1) / chunks;
+        int *hist = calloc(c->count, sizeof(int));
+        for (int v = lo; v < hi; v++) {
+            if (labels[v] != v) c->comp[v] = c->comp[labels[v]];
+            hist[c->comp[v]]++;
+        }
+        hists[t] = hist;
+    }
+    cilk_for(int i = 0; i < c->count; i++) {
+        int size = 0;
+        for (int j = 0; j < chunks; j++) size += hists[j][i];
+        c->sizes[i] = size;
+    }
+    for (int t = 0; t < chunks; t++) free(hists[t]);
+    free(root_count); free(hists);
+    return c;
+}
+
+void freeComponents(Components* c) {
+    if (!c) return;
+    free(c->comp); free(c->roots); free(c->sizes); free(c);
+}
+
+// Binary layout: magic, n, count, labels[n], comp[n], roots[count], sizes[count]
+void saveComponents(Graph* g, Components* c, const char* filename, bool csv) {
+    char name[512];
+    char tmp_name[520];
+    snprintf(name, sizeof(name), "%s.labels", filename);
+    snprintf(tmp_name, sizeof(tmp_name), "%s.tmp", name); // renamed into place so a live mmap never sees a partial file
+    FILE* f = fopen(tmp_name, "wb");
+    if (!f) { fprintf(stderr, "[Rank 0] Failed to write %s\n", name); return; }
+    fwrite(LABELS_MAGIC, 1, 4, f);
+    fwrite(&g->vertices, sizeof(int), 1, f);
+    fwrite(&c->count, sizeof(int), 1, f);
+    fwrite(g->labels, sizeof(int), g->vertices, f);
+    fwrite(c->comp, sizeof(int), g->vertices, f);
+    fwrite(c->roots, sizeof(int), c->count, f);
+    fwrite(c->sizes, sizeof(int), c->count, f);
+    fclose(f);
+    rename(tmp_name, name);
+    printf("Saved labels file: %s\n", name);
+    if (!csv) return;
+
+    snprintf(name, sizeof(name), "%s.labels.csv", filename);
+    if (!(f = fopen(name, "w"))) { fprintf(stderr, "[Rank 0] Failed to write %s\n", name); return; }
+    fprintf(f, "vertex,label,component\n");
+    for (int i = 0; i < g->vertices; i++) fprintf(f, "%d,%d,%d\n", i, g->labels[i], c->comp[i]);
+    fclose(f);
+
+    snprintf(name, sizeof(name), "%s.components.csv", filename);
+    if (!(f = fopen(name, "w"))) { fprintf(stderr, "[Rank 0] Failed to write %s\n", name); return; }
+    fprintf(f, "component,root,size\n");
+    for (int i = 0; i < c->count; i++) fprintf(f, "%d,%d,%d\n", i, c->roots[i], c->sizes[i]);
+    fclose(f);
+    printf("Saved CSV files: %s.labels.csv, %s.components.csv\n", filename, filename);
 }
 
 int main(int argc, char* argv[]) {
@@ -161,34 +357,62 @@ int main(int argc, char* argv[]) {
     MPI_Comm_size(MPI_COMM_WORLD, &size);
 
     if (argc < 2) {
-        if (rank == 0) printf("Usage: %s <file.mtx>\n", argv[0]);
+        if (rank == 0) printf("Usage: %s <file.mtx> [--labels] [--csv] [--perf] [--perf-iter]\n", argv[0]);
         MPI_Finalize(); return 1;
     }
+    bool save_labels = false, save_csv = false, use_perf = false;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--labels") == 0) save_labels = true;
+        else if (strcmp(argv[i], "--csv") == 0) save_labels = save_csv = true;
+        else if (strcmp(argv[i], "--perf") == 0) use_perf = true;
+        else if (strcmp(argv[i], "--perf-iter") == 0) use_perf = perf.per_iteration = true;
+    }
+    if (use_perf) {
+        cilk_for(int i = 0; i < __cilkrts_get_nworkers(); i++) {} // start the workers so they get counters
+        perf.combine = perfCombine;
+        perf.quiet = rank != 0;
+        perfOpen();
+    }
 
     Graph* g = NULL;
     if (rank == 0) {
         printf("[Rank 0] Loading %s...\n", argv[1]);
         g = readMTX(argv[1], rank);
+        if (!g) { printf("Failed to load graph from %s\n", argv[1]); MPI_Abort(MPI_COMM_WORLD, 1); }
     }
 
+    TRACE(trace.ranks = size; double phase_start = traceTime());
     BroadcastGraph(&g, rank);
+    TRACE(trace.phase[PHASE_BROADCAST] = traceTime() - phase_start);
     if (rank == 0) printf("Graph loaded: %d nodes, %lld entries.\n", g->vertices, g->num_edges);
 
+    perfSample("load", -1, 0);
     MPI_Barrier(MPI_COMM_WORLD);
     struct timespec start, end;
     if (rank == 0) clock_gettime(CLOCK_MONOTONIC, &start); 
 
-    ColoringAlgorithmHybrid(g, rank, size);
+    int iterations = ColoringAlgorithmHybrid(g, rank, size);
     
     MPI_Barrier(MPI_COMM_WORLD);
+    if (rank == 0) clock_gettime(CLOCK_MONOTONIC, &end);
+    perfSample("compute", -1, (double)iterations * g->num_edges);
     if (rank == 0) {
-        clock_gettime(CLOCK_MONOTONIC, &end); 
         double time = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
-        int comps = 0;
-        for (int i = 0; i < g->vertices; i++) if (g->labels[i] == i) comps++;
-        printf("Nodes: %d | Components: %d | Time: %f s\n", g->vertices, comps, time);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        Components* c = computeComponents(g, rank);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double post_time = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+        int largest = 0;
+        for (int i = 0; i < c->count; i++) if (c->sizes[i] > largest) largest = c->sizes[i];
+        printf("Nodes: %d | Edges: %lld | Ranks: %d | Components: %d | Largest: %d | Iterations: %d | Time: %f s | Stats: %f s\n",
+               g->vertices, g->num_edges, size, c->count, largest, iterations, time, post_time);
+        if (save_labels) saveComponents(g, c, argv[1], save_csv);
+        TRACE(trace.phase[PHASE_COMPUTE] = time; trace.phase[PHASE_STATS] = post_time);
+        TRACE(traceWrite(argv[1], g->vertices, g->num_edges));
+        freeComponents(c);
     }
 
+    perfClose();
     freeGraph(g);
     MPI_Finalize();
     return 0;
@@ -0,0 +1,364 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <omp.h>
+
+// Host build of the cc_cuda_v2 pipeline for machines without an NVIDIA card: the same kernels, launched in
+// the same order by the same driver loop, with every CUDA thread becoming an iteration of an OpenMP loop.
+// The warp-per-vertex link kernel keeps its 32 lanes as a lane array the compiler vectorizes: lane i takes
+// edges start + i, start + i + 32, ..., and the __shfl_down_sync tree becomes the same halving min over the
+// array. Labels, iterations and the .bin cache match the GPU build, so its output can be checked here.
+
+#define LABELS_MAGIC "CCL1"
+#define WARP_SIZE 32
+
+typedef struct Graph {
+    int vertices;
+    long long num_edges;
+    int *edges;
+    long long *offsets;
+    int *labels;
+    void *map; // mmapped binary cache holding edges, NULL when edges is malloc'd
+    size_t map_size;
+} Graph;
+
+typedef struct Components { // Per-vertex compacted component ids and per-component sizes
+    int count;
+    int *comp;
+    int *roots;
+    int *sizes;
+} Components;
+
+// --- 1. FIXED FILE IO ---
+
+inline int fast_parse_int(char *&p) {
+    int val = 0;
+    while (*p && (*p < '0' || *p > '9')) p++; 
+    if (!*p) return -1;
+    while (*p >= '0' && *p <= '9') {
+        val = val * 10 + (*p - '0');
+        p++;
+    }
+    return val;
+}
+
+// Header counts (nnz in particular) can exceed 2^31 on large inputs
+inline long long fast_parse_ll(char *&p) {
+    long long val = 0;
+    while (*p && (*p < '0' || *p > '9')) p++;
+    if (!*p) return -1;
+    while (*p >= '0' && *p <= '9') {
+        val = val * 10 + (*p - '0');
+        p++;
+    }
+    return val;
+}
+
+// Helper to skip weights/remaining text on a line
+inline void skip_line(char *&p) {
+    while (*p && *p != '\n') p++;
+    if (*p == '\n') p++;
+}
+
+Graph* createGraph(int vertices) {
+    Graph* g = (Graph*)malloc(sizeof(Graph));
+    if (!g) return NULL;
+    g->vertices = vertices;
+    g->num_edges = 0;
+    g->edges = NULL;
+    g->map = NULL;
+    g->map_size = 0;
+    g->offsets = (long long*)calloc((size_t)vertices + 1, sizeof(long long));
+    g->labels = (int*)malloc((size_t)vertices * sizeof(int));
+    for (int i = 0; i < vertices; i++) g->labels[i] = i; 
+    return g;
+}
+
+Graph *readMTX_Fast(const char* filename) {
+    int fd = open(filename, O_RDONLY);
+    if (fd == -1) return NULL;
+
+    struct stat st;
+    fstat(fd, &st);
+    size_t file_size = st.st_size;
+
+    char *map = (char*)mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) { close(fd); return NULL; }
+
+    char *p = map;
+    while (*p == '%') { skip_line(p); }
+
+    long long rows = fast_parse_ll(p);
+    long long cols = fast_parse_ll(p);
+    long long nnz = fast_parse_ll(p);
+    skip_line(p);
+
+    long long max_dim = (rows > cols) ? rows : cols;
+    if (max_dim > INT_MAX || nnz < 0) {
+        printf("Graph has %lld vertices, more than the 32-bit vertex ids of this build\n", max_dim);
+        munmap(map, file_size); close(fd); return NULL;
+    }
+    int n = (int)max_dim;
+    Graph *g = createGraph(n);
+    int *temp = (int*)calloc(n, sizeof(int));
+
+    char *p_pass1 = p;
+    for (long long i = 0; i < nnz; i++) {
+        int u = fast_parse_int(p_pass1) - 1;
+        int v = fast_parse_int(p_pass1) - 1;
+        skip_line(p_pass1); // Skip the weight column
+        if (u >= 0 && v >= 0 && u < n && v < n && u != v) {
+            temp[u]++; temp[v]++;
+        }
+    }
+
+    g->offsets[0] = 0;
+    for (int i = 1; i <= n; i++) g->offsets[i] = g->offsets[i-1] + temp[i-1];
+    g->num_edges = g->offsets[n];
+    g->edges = (int*)malloc((size_t)g->num_edges * sizeof(int));
+    
+    for (int i = 0; i < n; i++) temp[i] = 0;
+
+    char *p_pass2 = p;
+    for (long long i = 0; i < nnz; i++) {
+        int u = fast_parse_int(p_pass2) - 1;
+        int v = fast_parse_int(p_pass2) - 1;
+        skip_line(p_pass2); // Skip the weight column
+        if (u >= 0 && v >= 0 && u < n && v < n && u != v) {
+            g->edges[g->offsets[u] + (size_t)temp[u]++] = v;
+            g->edges[g->offsets[v] + (size_t)temp[v]++] = u;
+        }
+    }
+
+    munmap(map, file_size); close(fd); free(temp);
+    return g;
+}
+
+// Maps the cache: edges are used in place (only read to upload them), offsets are copied
+Graph* loadBinGraph(const char* filename) {
+    int fd = open(filename, O_RDONLY);
+    if (fd == -1) return NULL;
+    struct stat st;
+    if (fstat(fd, &st) == -1 || st.st_size < (off_t)(sizeof(int) + sizeof(long long))) { close(fd); return NULL; }
+    char *map = (char*)mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return NULL;
+    int n; long long num_edges;
+    memcpy(&n, map, sizeof(int));
+    memcpy(&num_edges, map + sizeof(int), sizeof(long long));
+    size_t header = sizeof(int) + sizeof(long long) + (size_t)(n + 1) * sizeof(long long);
+    if (n < 0 || num_edges < 0 || (size_t)st.st_size < header + (size_t)num_edges * sizeof(int)) { munmap(map, st.st_size); return NULL; }
+    Graph* g = createGraph(n);
+    g->num_edges = num_edges;
+    memcpy(g->offsets, map + sizeof(int) + sizeof(long long), (size_t)(n + 1) * sizeof(long long));
+    g->edges = (int*)(map + header);
+    g->map = map; g->map_size = st.st_size;
+    return g;
+}
+
+void saveBinGraph(Graph* g, const char* filename) {
+    FILE* f = fopen(filename, "wb");
+    if (!f) return;
+    fwrite(&g->vertices, sizeof(int), 1, f);
+    fwrite(&g->num_edges, sizeof(long long), 1, f);
+    fwrite(g->offsets, sizeof(long long), g->vertices + 1, f);
+    fwrite(g->edges, sizeof(int), g->num_edges, f);
+    fclose(f);
+}
+
+void freeGraph(Graph* g) {
+    if (!g) return;
+    if (g->map) munmap(g->map, g->map_size); else free(g->edges);
+    free(g->offsets); free(g->labels); free(g);
+}
+
+// --- 2. KERNELS (HOST) ---
+
+// atomicMin on host memory; the kernels read labels with plain loads as the GPU ones do
+static inline void atomicMin(int *addr, int val) {
+    int old = __atomic_load_n(addr, __ATOMIC_RELAXED);
+    while (val < old && !__atomic_compare_exchange_n(addr, &old, val, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+void init_labels_kernel(int *labels, int n) {
+    #pragma omp parallel for
+    for (int v = 0; v < n; v++) labels[v] = v;
+}
+
+void cc_sampling_kernel(const long long *offsets, const int *edges, int *labels, int n) {
+    #pragma omp parallel for
+    for (int v = 0; v < n; v++) {
+        long long start = offsets[v];
+        long long end = offsets[v+1];
+        int my_root = labels[v];
+        for (long long k = start; k < end && k < start + 2; k++) {
+            int neighbor = edges[k];
+            if (neighbor < my_root) my_root = neighbor;
+        }
+        if (my_root < labels[v]) atomicMin(&labels[v], my_root);
+    }
+}
+
+// One "warp" per vertex, dynamically scheduled so hub vertices do not stall a thread's static share
+void cc_link_kernel(const long long *offsets, const int *edges, int *labels, bool *changed, int n) {
+    #pragma omp parallel for schedule(dynamic, 64)
+    for (int v = 0; v < n; v++) {
+        long long start = offsets[v];
+        long long end = offsets[v+1];
+        int p_v = labels[v];
+        int lane_min[WARP_SIZE];
+        for (int lane = 0; lane < WARP_SIZE; lane++) lane_min[lane] = p_v;
+        for (long long k = start; k < end; k += WARP_SIZE) {
+            int width = (end - k < WARP_SIZE) ? (int)(end - k) : WARP_SIZE;
+            const int *chunk = edges + k;
+            #pragma omp simd
+            for (int lane = 0; lane < width; lane++) {
+                int neighbor_label = labels[chunk[lane]];
+                if (neighbor_label < lane_min[lane]) lane_min[lane] = neighbor_label;
+            }
+        }
+        for (int offset = WARP_SIZE / 2; offset > 0; offset /= 2) {
+            #pragma omp simd
+            for (int lane = 0; lane < offset; lane++) {
+                if (lane_min[lane + offset] < lane_min[lane]) lane_min[lane] = lane_min[lane + offset];
+            }
+        }
+        int min_label = lane_min[0];
+        if (min_label < p_v) {
+            atomicMin(&labels[v], min_label);
+            atomicMin(&labels[p_v], min_label);
+            __atomic_store_n(changed, true, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+void cc_compress_kernel(int *labels, int n) {
+    #pragma omp parallel for
+    for (int v = 0; v < n; v++) {
+        int p = labels[v];
+        int pp = labels[p];
+        if (p != pp) labels[v] = pp;
+    }
+}
+
+int max_iterations = 0; // --max-iter: link rounds to stop after, 0 runs until no label changes
+
+// Same launch sequence as ColoringAlgorithmCUDA; the graph is already in host memory, so nothing is copied
+void ColoringAlgorithmCPU(Graph* g) {
+    int n = g->vertices;
+    int *labels = g->labels;
+    bool changed;
+    init_labels_kernel(labels, n);
+    cc_sampling_kernel(g->offsets, g->edges, labels, n);
+    cc_compress_kernel(labels, n);
+    int iterations = 0;
+    do {
+        changed = false;
+        cc_link_kernel(g->offsets, g->edges, labels, &changed, n);
+        cc_compress_kernel(labels, n);
+        iterations++;
+    } while (changed && (max_iterations == 0 || iterations < max_iterations));
+    for(int i=0; i<4; i++) cc_compress_kernel(labels, n);
+    if (changed) printf("Stopped after %d iterations (--max-iter), labels may not be final.\n", iterations);
+    else printf("Converged in %d iterations.\n", iterations);
+}
+
+
+// --- 3. COMPONENT OUTPUT ---
+
+// Host-side compaction: labels[v] <= v after convergence, so one ascending pass assigns every id
+Components* computeComponents(Graph* g) {
+    int n = g->vertices;
+    Components* c = (Components*)malloc(sizeof(Components));
+    c->comp = (int*)malloc((size_t)n * sizeof(int));
+    c->count = 0;
+    for (int v = 0; v < n; v++) if (g->labels[v] == v) c->count++;
+    c->roots = (int*)malloc((size_t)c->count * sizeof(int));
+    c->sizes = (int*)calloc(c->count, sizeof(int));
+    int id = 0;
+    for (int v = 0; v < n; v++) {
+        if (g->labels[v] == v) { c->comp[v] = id; c->roots[id++] = v; }
+        else c->comp[v] = c->comp[g->labels[v]];
+        c->sizes[c->comp[v]]++;
+    }
+    return c;
+}
+
+void freeComponents(Components* c) {
+    if (!c) return;
+    free(c->comp); free(c->roots); free(c->sizes); free(c);
+}
+
+// Binary layout: magic, n, count, labels[n], comp[n], roots[count], sizes[count]
+void saveComponents(Graph* g, Components* c, const char* filename, bool csv) {
+    char name[512];
+    char tmp_name[520];
+    snprintf(name, sizeof(name), "%s.labels", filename);
+    snprintf(tmp_name, sizeof(tmp_name), "%s.tmp", name); // renamed into place so a live mmap never sees a partial file
+    FILE* f = fopen(tmp_name, "wb");
+    if (!f) { printf("Failed to write %s\n", name); return; }
+    fwrite(LABELS_MAGIC, 1, 4, f);
+    fwrite(&g->vertices, sizeof(int), 1, f);
+    fwrite(&c->count, sizeof(int), 1, f);
+    fwrite(g->labels, sizeof(int), g->vertices, f);
+    fwrite(c->comp, sizeof(int), g->vertices, f);
+    fwrite(c->roots, sizeof(int), c->count, f);
+    fwrite(c->sizes, sizeof(int), c->count, f);
+    fclose(f);
+    rename(tmp_name, name);
+    printf("Saved labels: %s\n", name);
+    if (!csv) return;
+
+    snprintf(name, sizeof(name), "%s.labels.csv", filename);
+    if (!(f = fopen(name, "w"))) { printf("Failed to write %s\n", name); return; }
+    fprintf(f, "vertex,label,component\n");
+    for (int i = 0; i < g->vertices; i++) fprintf(f, "%d,%d,%d\n", i, g->labels[i], c->comp[i]);
+    fclose(f);
+
+    snprintf(name, sizeof(name), "%s.components.csv", filename);
+    if (!(f = fopen(name, "w"))) { printf("Failed to write %s\n", name); return; }
+    fprintf(f, "component,root,size\n");
+    for (int i = 0; i < c->count; i++) fprintf(f, "%d,%d,%d\n", i, c->roots[i], c->sizes[i]);
+    fclose(f);
+    printf("Saved CSV: %s.labels.csv, %s.components.csv\n", filename, filename);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) { printf("Usage: %s <file.mtx> [--labels] [--csv] [--max-iter N]\n", argv[0]); return 1; }
+    bool save_labels = false, save_csv = false;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--labels") == 0) save_labels = true;
+        else if (strcmp(argv[i], "--csv") == 0) save_labels = save_csv = true;
+        else if (strcmp(argv[i], "--max-iter") == 0 && i + 1 < argc) max_iterations = atoi(argv[++i]);
+    }
+    char bin_name[256]; snprintf(bin_name, sizeof(bin_name), "%s.bin", argv[1]);
+    
+    printf("Loading graph...\n");
+    Graph* g = loadBinGraph(bin_name);
+    if (!g) {
+        g = readMTX_Fast(argv[1]);
+        if (!g) return 1;
+        saveBinGraph(g, bin_name);
+    } else printf("Loaded binary: %s\n", bin_name);
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    ColoringAlgorithmCPU(g);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    
+    double time_taken = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    Components* c = computeComponents(g);
+    int largest = 0;
+    for (int i = 0; i < c->count; i++) if (c->sizes[i] > largest) largest = c->sizes[i];
+
+    printf("Total Vertices: %d\nTotal Edges: %lld\nThreads: %d\nComponents: %d\nLargest Component: %d\nCPU Kernel Time: %f s\n", g->vertices, g->num_edges, omp_get_max_threads(), c->count, largest, time_taken);
+    if (save_labels) saveComponents(g, c, argv[1], save_csv);
+    freeComponents(c); freeGraph(g); return 0;
+}
@@ -3,11 +3,15 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <limits.h>
 #include <time.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <string.h>
+
+#define LABELS_MAGIC "CCL1"
 
 #define cudaCheck(err) { \
     if (err != cudaSuccess) { \
@@ -22,8 +26,17 @@ typedef struct Graph {
     int *edges;
     long long *offsets;
     int *labels;
+    void *map; // mmapped binary cache holding edges, NULL when edges is malloc'd
+    size_t map_size;
 } Graph;
 
+typedef struct Components { // Per-vertex compacted component ids and per-component sizes
+    int count;
+    int *comp;
+    int *roots;
+    int *sizes;
+} Components;
+
 // --- 1. FIXED FILE IO ---
 
 inline int fast_parse_int(char *&p) {
@@ -37,6 +50,18 @@ inline int fast_parse_int(char *&p) {
     return val;
 }
 
+// Header counts (nnz in particular) can exceed 2^31 on large inputs
+inline long long fast_parse_ll(char *&p) {
+    long long val = 0;
+    while (*p && (*p < '0' || *p > '9')) p++;
+    if (!*p) return -1;
+    while (*p >= '0' && *p <= '9') {
+        val = val * 10 + (*p - '0');
+        p++;
+    }
+    return val;
+}
+
 // Helper to skip weights/remaining text on a line
 inline void skip_line(char *&p) {
     while (*p && *p != '\n') p++;
@@ -49,6 +74,8 @@ Graph* createGraph(int vertices) {
     g->vertices = vertices;
     g->num_edges = 0;
     g->edges = NULL;
+    g->map = NULL;
+    g->map_size = 0;
     g->offsets = (long long*)calloc((size_t)vertices + 1, sizeof(long long));
     g->labels = (int*)malloc((size_t)vertices * sizeof(int));
     for (int i = 0; i < vertices; i++) g->labels[i] = i; 
@@ -69,12 +96,17 @@ Graph *readMTX_Fast(const char* filename) {
     char *p = map;
     while (*p == '%') { skip_line(p); }
 
-    int rows = fast_parse_int(p);
-    int cols = fast_parse_int(p);
-    long long nnz = fast_parse_int(p);
+    long long rows = fast_parse_ll(p);
+    long long cols = fast_parse_ll(p);
+    long long nnz = fast_parse_ll(p);
     skip_line(p);
 
-    int n = (rows > cols) ? rows : cols;
+    long long max_dim = (rows > cols) ? rows : cols;
+    if (max_dim > INT_MAX || nnz < 0) {
+        printf("Graph has %lld vertices, more than the 32-bit vertex ids of this build\n", max_dim);
+        munmap(map, file_size); close(fd); return NULL;
+    }
+    int n = (int)max_dim;
     Graph *g = createGraph(n);
     int *temp = (int*)calloc(n, sizeof(int));
 
@@ -110,17 +142,26 @@ Graph *readMTX_Fast(const char* filename) {
     return g;
 }
 
+// Maps the cache: edges are used in place (only read to upload them), offsets are copied
 Graph* loadBinGraph(const char* filename) {
-    FILE* f = fopen(filename, "rb");
-    if (!f) return NULL;
+    int fd = open(filename, O_RDONLY);
+    if (fd == -1) return NULL;
+    struct stat st;
+    if (fstat(fd, &st) == -1 || st.st_size < (off_t)(sizeof(int) + sizeof(long long))) { close(fd); return NULL; }
+    char *map = (char*)mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return NULL;
     int n; long long num_edges;
-    if (fread(&n, sizeof(int), 1, f) != 1 || fread(&num_edges, sizeof(long long), 1, f) != 1) { fclose(f); return NULL; }
+    memcpy(&n, map, sizeof(int));
+    memcpy(&num_edges, map + sizeof(int), sizeof(long long));
+    size_t header = sizeof(int) + sizeof(long long) + (size_t)(n + 1) * sizeof(long long);
+    if (n < 0 || num_edges < 0 || (size_t)st.st_size < header + (size_t)num_edges * sizeof(int)) { munmap(map, st.st_size); return NULL; }
     Graph* g = createGraph(n);
     g->num_edges = num_edges;
-    g->edges = (int*)malloc((size_t)num_edges * sizeof(int));
-    size_t r1 = fread(g->offsets, sizeof(long long), n+1, f);
-    size_t r2 = fread(g->edges, sizeof(int), num_edges, f);
-    (void)r1; (void)r2; fclose(f); return g;
+    memcpy(g->offsets, map + sizeof(int) + sizeof(long long), (size_t)(n + 1) * sizeof(long long));
+    g->edges = (int*)(map + header);
+    g->map = map; g->map_size = st.st_size;
+    return g;
 }
 
 void saveBinGraph(Graph* g, const char* filename) {
@@ -135,7 +176,8 @@ void saveBinGraph(Graph* g, const char* filename) {
 
 void freeGraph(Graph* g) {
     if (!g) return;
-    free(g->edges); free(g->offsets); free(g->labels); free(g);
+    if (g->map) munmap(g->map, g->map_size); else free(g->edges);
+    free(g->offsets); free(g->labels); free(g);
 }
 
 // --- 2. CUDA KERNELS ---
@@ -195,6 +237,8 @@ __global__ void cc_compress_kernel(int *labels, int n) {
     }
 }
 
+int max_iterations = 0; // --max-iter: link rounds to stop after, 0 runs until no label changes
+
 void ColoringAlgorithmCUDA(Graph* g) {
     int n = g->vertices;
     int *d_labels, *d_edges; long long *d_offsets; bool *d_changed, h_changed;
@@ -219,16 +263,82 @@ void ColoringAlgorithmCUDA(Graph* g) {
         cudaDeviceSynchronize();
         cudaCheck(cudaMemcpy(&h_changed, d_changed, sizeof(bool), cudaMemcpyDeviceToHost));
         iterations++;
-    } while (h_changed && iterations < 50);
+    } while (h_changed && (max_iterations == 0 || iterations < max_iterations));
     for(int i=0; i<4; i++) cc_compress_kernel<<<blocks_v, threads>>>(d_labels, n);
-    printf("Converged in %d iterations.\n", iterations);
+    if (h_changed) printf("Stopped after %d iterations (--max-iter), labels may not be final.\n", iterations);
+    else printf("Converged in %d iterations.\n", iterations);
     cudaCheck(cudaMemcpy(g->labels, d_labels, (size_t)n * sizeof(int), cudaMemcpyDeviceToHost));
     cudaFree(d_labels); cudaFree(d_offsets); cudaFree(d_edges); cudaFree(d_changed);
 }
 
 
+// --- 3. COMPONENT OUTPUT ---
+
+// Host-side compaction: labels[v] <= v after convergence, so one ascending pass assigns every id
+Components* computeComponents(Graph* g) {
+    int n = g->vertices;
+    Components* c = (Components*)malloc(sizeof(Components));
+    c->comp = (int*)malloc((size_t)n * sizeof(int));
+    c->count = 0;
+    for (int v = 0; v < n; v++) if (g->labels[v] == v) c->count++;
+    c->roots = (int*)malloc((size_t)c->count * sizeof(int));
+    c->sizes = (int*)calloc(c->count, sizeof(int));
+    int id = 0;
+    for (int v = 0; v < n; v++) {
+        if (g->labels[v] == v) { c->comp[v] = id; c->roots[id++] = v; }
+        else c->comp[v] = c->comp[g->labels[v]];
+        c->sizes[c->comp[v]]++;
+    }
+    return c;
+}
+
+void freeComponents(Components* c) {
+    if (!c) return;
+    free(c->comp); free(c->roots); free(c->sizes); free(c);
+}
+
+// Binary layout: magic, n, count, labels[n], comp[n], roots[count], sizes[count]
+void saveComponents(Graph* g, Components* c, const char* filename, bool csv) {
+    char name[512];
+    char tmp_name[520];
+    snprintf(name, sizeof(name), "%s.labels", filename);
+    snprintf(tmp_name, sizeof(tmp_name), "%s.tmp", name); // renamed into place so a live mmap never sees a partial file
+    FILE* f = fopen(tmp_name, "wb");
+    if (!f) { printf("Failed to write %s\n", name); return; }
+    fwrite(LABELS_MAGIC, 1, 4, f);
+    fwrite(&g->vertices, sizeof(int), 1, f);
+    fwrite(&c->count, sizeof(int), 1, f);
+    fwrite(g->labels, sizeof(int), g->vertices, f);
+    fwrite(c->comp, sizeof(int), g->vertices, f);
+    fwrite(c->roots, sizeof(int), c->count, f);
+    fwrite(c->sizes, sizeof(int), c->count, f);
+    fclose(f);
+    rename(tmp_name, name);
+    printf("Saved labels: %s\n", name);
+    if (!csv) return;
+
+    snprintf(name, sizeof(name), "%s.labels.csv", filename);
+    if (!(f = fopen(name, "w"))) { printf("Failed to write %s\n", name); return; }
+    fprintf(f, "vertex,label,component\n");
+    for (int i = 0; i < g->vertices; i++) fprintf(f, "%d,%d,%d\n", i, g->labels[i], c->comp[i]);
+    fclose(f);
+
+    snprintf(name, sizeof(name), "%s.components.csv", filename);
+    if (!(f = fopen(name, "w"))) { printf("Failed to write %s\n", name); return; }
+    fprintf(f, "component,root,size\n");
+    for (int i = 0; i < c->count; i++) fprintf(f, "%d,%d,%d\n", i, c->roots[i], c->sizes[i]);
+    fclose(f);
+    printf("Saved CSV: %s.labels.csv, %s.components.csv\n", filename, filename);
+}
+
 int main(int argc, char* argv[]) {
-    if (argc < 2) { printf("Usage: %s <file.mtx>\n", argv[0]); return 1; }
+    if (argc < 2) { printf("Usage: %s <file.mtx> [--labels] [--csv] [--max-iter N]\n", argv[0]); return 1; }
+    bool save_labels = false, save_csv = false;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--labels") == 0) save_labels = true;
+        else if (strcmp(argv[i], "--csv") == 0) save_labels = save_csv = true;
+        else if (strcmp(argv[i], "--max-iter") == 0 && i + 1 < argc) max_iterations = atoi(argv[++i]);
+    }
     char bin_name[256]; snprintf(bin_name, sizeof(bin_name), "%s.bin", argv[1]);
     
     printf("Loading graph...\n");
@@ -245,9 +355,11 @@ int main(int argc, char* argv[]) {
     clock_gettime(CLOCK_MONOTONIC, &end);
     
     double time_taken = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
-    int num_components = 0;
-    for (int i = 0; i < g->vertices; i++) if (g->labels[i] == i) num_components++;
+    Components* c = computeComponents(g);
+    int largest = 0;
+    for (int i = 0; i < c->count; i++) if (c->sizes[i] > largest) largest = c->sizes[i];
 
-    printf("Total Vertices: %d\nComponents: %d\nGPU Kernel Time: %f s\n", g->vertices, num_components, time_taken);
-    freeGraph(g); return 0;
+    printf("Total Vertices: %d\nTotal Edges: %lld\nComponents: %d\nLargest Component: %d\nGPU Kernel Time: %f s\n", g->vertices, g->num_edges, c->count, largest, time_taken);
+    if (save_labels) saveComponents(g, c, argv[1], save_csv);
+    freeComponents(c); freeGraph(g); return 0;
 }
\ No newline at end of file
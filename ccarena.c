@@ -0,0 +1,149 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "ccarena.h"
+#include "ccparallel.h"
+
+bool arena_recycle = false;
+Arena spare = {0};
+
+bool arenaCreate(Arena *a, size_t bytes){
+
+    const char *mode = getenv("CC_HUGEPAGES");
+    size_t size = (bytes + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+
+    memset(a, 0, sizeof(Arena));
+
+    if(size == 0){
+        size = HUGE_PAGE_SIZE;
+    }
+    if(mode && strcmp(mode, "explicit") == 0){
+
+        void *p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+        if(p != MAP_FAILED){
+            a->base = p;
+            a->size = size;
+            a->backing = "explicit";
+            return true;
+        }
+    }
+
+    // Over-map by one huge page and trim both ends so the arena starts on a 2 MB boundary
+    char *raw = mmap(NULL, size + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+    if(raw == MAP_FAILED){
+        return false;
+    }
+    char *base = (char*)(((uintptr_t)raw + HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(HUGE_PAGE_SIZE - 1));
+
+    if(base > raw){
+        munmap(raw, base - raw);
+    }
+    munmap(base + size, raw + HUGE_PAGE_SIZE - base);
+
+    a->base = base;
+    a->size = size;
+
+    if(mode && strcmp(mode, "0") == 0){
+        madvise(base, size, MADV_NOHUGEPAGE);
+        a->backing = "4k";
+    }
+    else{
+        a->backing = (madvise(base, size, MADV_HUGEPAGE) == 0) ? "thp" : "4k";
+    }
+    return true;
+}
+
+void *arenaAlloc(Arena *a, size_t bytes){
+
+    size_t start = (a->used + CACHE_LINE - 1) & ~(size_t)(CACHE_LINE - 1);
+
+    if(start + bytes > a->size){
+        return NULL;
+    }
+    a->used = start + bytes;
+    return a->base + start;
+}
+
+void arenaTrim(Arena *a, void *last, size_t bytes){
+
+    char *end = (char*)last + bytes;
+    char *page = (char*)(((uintptr_t)end + SMALL_PAGE_SIZE - 1) & ~(uintptr_t)(SMALL_PAGE_SIZE - 1));
+
+    if(page < a->base + a->used){
+        madvise(page, a->base + a->used - page, MADV_DONTNEED);
+    }
+    a->used = end - a->base;
+}
+
+void arenaAdopt(Arena *a, void *map, size_t size){
+    madvise(map, size, MADV_HUGEPAGE);
+    a->map = map;
+    a->map_size = size;
+}
+
+void arenaFree(Arena *a){
+
+    if(a->map){
+        munmap(a->map, a->map_size);
+    }
+    if(arena_recycle && a->base && a->size > spare.size){
+        if(spare.base){
+            munmap(spare.base, spare.size);
+        }
+        spare = *a;
+        spare.map = NULL;
+        spare.map_size = 0;
+    }
+    else if(a->base){
+        munmap(a->base, a->size);
+    }
+}
+
+typedef struct Span{
+    char *base;
+}Span;
+
+void touchPages(void *arg, long long begin, long long end){ // one byte of every page in [begin, end)
+
+    char *base = ((Span*)arg)->base;
+
+    for(long long i = begin; i < end; i++){
+        base[i * SMALL_PAGE_SIZE] = 0;
+    }
+}
+
+void clearPages(void *arg, long long begin, long long end){
+
+    char *base = ((Span*)arg)->base;
+
+    memset(base + begin * SMALL_PAGE_SIZE, 0, (end - begin) * SMALL_PAGE_SIZE);
+}
+
+void arenaTouch(void *p, size_t bytes){
+
+    Span span = {p};
+
+    parallelFor((bytes + SMALL_PAGE_SIZE - 1) / SMALL_PAGE_SIZE, 1, touchPages, &span);
+}
+
+bool arenaReuse(Arena *a, size_t bytes){
+
+    if(spare.base && spare.size < bytes){
+        munmap(spare.base, spare.size);
+        memset(&spare, 0, sizeof(Arena));
+    }
+    if(!spare.base){
+        return false;
+    }
+    Span span = {spare.base};
+
+    parallelFor((spare.used + SMALL_PAGE_SIZE - 1) / SMALL_PAGE_SIZE, 1, clearPages, &span); // whole pages, the arena is page aligned
+
+    *a = spare;
+    a->used = 0;
+    memset(&spare, 0, sizeof(Arena));
+    return true;
+}
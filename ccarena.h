@@ -0,0 +1,41 @@
+#ifndef CCARENA_H
+#define CCARENA_H
+
+// All arrays of a Graph live in one arena: a single anonymous mapping aligned to 2 MB so the random
+// labels[edges[k]] gathers can hit huge pages instead of thrashing the TLB with 4 KB ones. CC_HUGEPAGES picks
+// the backing: "explicit" (hugetlbfs pages reserved via /proc/sys/vm/nr_hugepages, falls back to thp when
+// there are not enough), "thp" (default, madvise'd transparent huge pages) or "0" (4 KB pages). Arrays are
+// carved at cache-line boundaries and first touched through the backend's parallel hook (ccparallel.h), so
+// pages are zeroed by, and on the memory node of, the threads that sweep them. A mapped binary cache is
+// adopted by the arena so freeGraph releases everything in one place.
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define HUGE_PAGE_SIZE (2UL << 20)
+#define SMALL_PAGE_SIZE 4096
+#define CACHE_LINE 64
+
+typedef struct Arena{
+    char *base;
+    size_t size;
+    size_t used;
+    const char *backing; // "explicit", "thp" or "4k"
+    void *map;           // adopted binary cache holding edges, NULL when edges are in the arena
+    size_t map_size;
+}Arena;
+
+// Batch mode keeps the arena of the last freed graph mapped, its pages already faulted in and placed, and
+// hands it to the next graph that fits. A graph that does not fit releases it first, so it only grows.
+extern bool arena_recycle;
+extern Arena spare;
+
+bool arenaCreate(Arena *a, size_t bytes);           // Reserves bytes rounded up to whole huge pages, untouched pages cost nothing
+void *arenaAlloc(Arena *a, size_t bytes);           // Cache-line aligned, NULL once the arena is full
+void arenaTrim(Arena *a, void *last, size_t bytes); // Shrinks the most recent allocation and returns its whole pages
+void arenaAdopt(Arena *a, void *map, size_t size);  // File-backed huge pages need tmpfs huge= or READ_ONLY_THP_FOR_FS, else a no-op
+void arenaFree(Arena *a);                           // Unmaps the arena, or keeps it as the spare when recycling
+void arenaTouch(void *p, size_t bytes);             // Parallel first touch in contiguous blocks, the mapping is already zero
+bool arenaReuse(Arena *a, size_t bytes);            // Takes the spare arena when it fits, the part the last graph used is zeroed again
+
+#endif
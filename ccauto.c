@@ -0,0 +1,289 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "ccauto.h"
+#include "ccparallel.h"
+
+typedef struct Degrees{ // autoAnalyze's degree pass, merged into by every range
+    const Graph *g;
+    long long histogram[64];
+    long long max_degree;
+    long long isolated;
+}Degrees;
+
+void countDegrees(void *arg, long long begin, long long end){
+
+    Degrees *d = (Degrees*)arg;
+    long long histogram[64] = {0};
+    long long max_degree = 0;
+    long long isolated = 0;
+
+    for(long long v = begin; v < end; v++){
+
+        long long deg = d->g->offsets[v + 1] - d->g->offsets[v];
+        int bucket = 0;
+
+        while(bucket < 63 && (1LL << bucket) < deg){
+            bucket++;
+        }
+        histogram[bucket]++;
+        isolated += (deg == 0);
+        if(deg > max_degree){
+            max_degree = deg;
+        }
+    }
+    for(int bucket = 0; bucket < 64; bucket++){
+        if(histogram[bucket]){
+            __atomic_fetch_add(&d->histogram[bucket], histogram[bucket], __ATOMIC_RELAXED);
+        }
+    }
+    __atomic_fetch_add(&d->isolated, isolated, __ATOMIC_RELAXED);
+
+    long long seen = __atomic_load_n(&d->max_degree, __ATOMIC_RELAXED);
+
+    while(max_degree > seen && !__atomic_compare_exchange_n(&d->max_degree, &seen, max_degree, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)){
+    }
+}
+
+void clearLevels(void *arg, long long begin, long long end){
+
+    vertex_t *level = (vertex_t*)arg;
+
+    for(long long v = begin; v < end; v++){
+        level[v] = -1;
+    }
+}
+
+vertex_t autoBFS(Graph* g, vertex_t root, vertex_t* level, vertex_t* queue, vertex_t* depth){ // Returns the vertices reached, the last one dequeued is queue[reached - 1]
+
+    vertex_t head = 0;
+    vertex_t tail = 0;
+
+    level[root] = 0;
+    queue[tail++] = root;
+
+    while(head < tail){
+
+        vertex_t v = queue[head++];
+
+        for(edge_t k = g->offsets[v]; k < g->offsets[v + 1]; k++){
+
+            vertex_t u = g->edges[k];
+
+            if(level[u] < 0){
+                level[u] = level[v] + 1;
+                queue[tail++] = u;
+            }
+        }
+    }
+    *depth = level[queue[tail - 1]];
+
+    for(vertex_t i = 0; i < tail; i++){ // reset only what this BFS touched
+        level[queue[i]] = -1;
+    }
+    return tail;
+}
+
+void autoDecide(AutoChoice* a){
+
+    long llc = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    double bytes = (double)a->vertices * (sizeof(edge_t) + sizeof(vertex_t)) + (double)a->edges * sizeof(vertex_t);
+
+    if(llc <= 0){
+        llc = AUTO_DEFAULT_LLC;
+    }
+
+    if(a->depth >= AUTO_DEEP){
+        snprintf(a->engine, sizeof(a->engine), "contract");
+        snprintf(a->reason, sizeof(a->reason), "a BFS went %lld levels deep, label propagation would need as many rounds", (long long)a->depth);
+    }
+    else if(a->giant >= AUTO_GIANT){
+        snprintf(a->engine, sizeof(a->engine), "peel");
+        snprintf(a->reason, sizeof(a->reason), "one BFS reached %.1f%% of the non-isolated vertices within %lld levels", 100.0 * a->giant, (long long)a->depth);
+    }
+    else if(bytes > llc){
+        snprintf(a->engine, sizeof(a->engine), "blocked");
+        snprintf(a->reason, sizeof(a->reason), "CSR and labels take %.1f MB, more than the %.1f MB LLC", bytes / 1048576.0, llc / 1048576.0);
+    }
+    else{
+        snprintf(a->engine, sizeof(a->engine), "lp");
+        snprintf(a->reason, sizeof(a->reason), "BFS depth %lld, no giant component and the CSR fits the %.1f MB LLC", (long long)a->depth, llc / 1048576.0);
+    }
+
+    double per_vertex = a->avg_degree > 1 ? a->avg_degree : 1;
+    int chunk = 64;
+
+    while(chunk < 4096 && 2 * chunk * per_vertex <= AUTO_CHUNK_EDGES){
+        chunk *= 2;
+    }
+    if(a->max_degree > AUTO_CHUNK_EDGES && chunk > 64){ // hubs make chunks uneven, smaller ones balance better
+        chunk /= 2;
+    }
+    a->chunk = chunk;
+
+    long long threads = a->edges / AUTO_THREAD_EDGES;
+    a->threads = (threads < 1) ? 1 : (threads > 4096) ? 4096 : (int)threads;
+}
+
+void autoSource(const char* filename, long long* size, long long* mtime){ // The input, or the binary cache when there is none
+
+    char bin_name[512];
+    struct stat st;
+
+    snprintf(bin_name, sizeof(bin_name), "%s" BIN_SUFFIX, filename);
+    if(stat(filename, &st) != 0 && stat(bin_name, &st) != 0){
+        *size = -1;
+        *mtime = -1;
+        return;
+    }
+    *size = st.st_size;
+    *mtime = (long long)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+}
+
+bool autoLoad(const char* filename, Graph* g, AutoChoice* a){
+
+    char name[512];
+    snprintf(name, sizeof(name), "%s.auto", filename);
+
+    FILE* f = fopen(name, "r");
+
+    if(!f){
+        return false;
+    }
+    memset(a, 0, sizeof(AutoChoice));
+
+    long long depth = 0;
+    long long size, mtime;
+    bool ok = fscanf(f, "ccauto %lld %lld source %lld %lld\n", &a->vertices, &a->edges, &a->source_size, &a->source_mtime) == 4 &&
+              fscanf(f, "degree max %lld p99 %lld avg %lf isolated %lld\n", &a->max_degree, &a->p99_degree, &a->avg_degree, &a->isolated) == 4 &&
+              fscanf(f, "bfs depth %lld giant %lf\n", &depth, &a->giant) == 2 &&
+              fscanf(f, "engine %15s chunk %d threads %d\n", a->engine, &a->chunk, &a->threads) == 3 &&
+              fscanf(f, "reason %191[^\n]", a->reason) == 1;
+
+    fclose(f);
+    autoSource(filename, &size, &mtime);
+    a->depth = (vertex_t)depth;
+    a->cached = true;
+    return ok && a->source_size == size && a->source_mtime == mtime && size >= 0 &&
+           a->vertices == g->vertices && a->edges == (long long)g->offsets[g->vertices] && a->chunk > 0 && a->threads > 0;
+}
+
+void autoSave(const char* filename, const AutoChoice* a){
+
+    char name[512];
+    char tmp_name[520];
+    snprintf(name, sizeof(name), "%s.auto", filename);
+    snprintf(tmp_name, sizeof(tmp_name), "%s.tmp", name);
+
+    FILE* f = fopen(tmp_name, "w");
+
+    if(!f){
+        printf("Failed to write %s\n", name);
+        return;
+    }
+    fprintf(f, "ccauto %lld %lld source %lld %lld\n", a->vertices, a->edges, a->source_size, a->source_mtime);
+    fprintf(f, "degree max %lld p99 %lld avg %f isolated %lld\n", a->max_degree, a->p99_degree, a->avg_degree, a->isolated);
+    fprintf(f, "bfs depth %lld giant %f\n", (long long)a->depth, a->giant);
+    fprintf(f, "engine %s chunk %d threads %d\n", a->engine, a->chunk, a->threads);
+    fprintf(f, "reason %s\n", a->reason);
+    fclose(f);
+    rename(tmp_name, name);
+}
+
+bool autoAnalyze(const char* filename, Graph* g, AutoChoice* a){
+
+    if(autoLoad(filename, g, a)){
+        return true;
+    }
+    memset(a, 0, sizeof(AutoChoice));
+
+    double start = wallTime();
+    vertex_t n = g->vertices;
+    Degrees d;
+    vertex_t hub = 0;
+
+    memset(&d, 0, sizeof(Degrees));
+    d.g = g;
+    autoSource(filename, &a->source_size, &a->source_mtime);
+    a->vertices = n;
+    a->edges = g->offsets[n];
+    a->avg_degree = n ? (double)a->edges / n : 0.0;
+
+    parallelFor(n, 4, countDegrees, &d);
+    a->max_degree = d.max_degree;
+    a->isolated = d.isolated;
+
+    long long below = 0;
+
+    for(int bucket = 0; bucket < 64; bucket++){
+        below += d.histogram[bucket];
+        if(below * 100 >= (long long)n * 99){
+            a->p99_degree = 1LL << bucket;
+            break;
+        }
+    }
+
+    for(vertex_t v = 0; v < n; v++){
+        if((long long)(g->offsets[v + 1] - g->offsets[v]) == d.max_degree){
+            hub = v;
+            break;
+        }
+    }
+
+    if(n > 0){
+
+        vertex_t* level = malloc(n * sizeof(vertex_t));
+        vertex_t* queue = malloc(n * sizeof(vertex_t));
+
+        if(!level || !queue){
+            free(level);
+            free(queue);
+            return false;
+        }
+        parallelFor(n, 1, clearLevels, level);
+
+        unsigned long long seed = (unsigned long long)n * 2654435761ULL + 1;
+        vertex_t root = hub;
+        vertex_t reached_most = 0;
+
+        for(int s = 0; s < AUTO_SAMPLES; s++){
+
+            vertex_t depth;
+            vertex_t reached = autoBFS(g, root, level, queue, &depth);
+
+            if(depth > a->depth){
+                a->depth = depth;
+            }
+            if(reached > reached_most){
+                reached_most = reached;
+            }
+            if(s >= 1 && reached_most >= AUTO_GIANT * (n - a->isolated)){ // random roots would mostly land in the same giant
+                break;
+            }
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            root = (s == 0) ? queue[reached - 1] : (vertex_t)((seed >> 33) % (unsigned long long)n);
+        }
+        a->giant = (n > a->isolated) ? (double)reached_most / (n - a->isolated) : 0.0;
+        free(level);
+        free(queue);
+    }
+
+    autoDecide(a);
+    a->seconds = wallTime() - start;
+    autoSave(filename, a);
+    return true;
+}
+
+void autoReport(const char* filename, const AutoChoice* a){
+
+    printf("Graph analysis: max degree %lld, 99%% of degrees <= %lld, average %.2f, %lld isolated, BFS depth >= %lld, giant %.1f%%",
+           a->max_degree, a->p99_degree, a->avg_degree, a->isolated, (long long)a->depth, 100.0 * a->giant);
+    if(a->cached){
+        printf(" (cached in %s.auto)\n", filename);
+    }
+    else{
+        printf(" (%f seconds)\n", a->seconds);
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef CCAUTO_H
+#define CCAUTO_H
+
+// Automatic engine and parameter selection (ccopenmp --engine auto, ccpthreads --auto). A pre-analysis pass
+// takes the degree distribution and estimates the diameter: a BFS from the highest-degree vertex, one from
+// the vertex it reached last (the double sweep, whose depth is close to the diameter on most graphs) and,
+// unless those already covered a giant component, AUTO_SAMPLES - 2 from random vertices.
+//
+// The engine is one of libcc's. Propagation needs about one round per level of the deepest component, so
+// deep graphs go to "contract"; when one BFS covers nearly every non-isolated vertex "peel" labels it in
+// that many levels; graphs whose CSR and labels outgrow the LLC go to "blocked" and the rest to "lp". The
+// sweep chunk is sized to about AUTO_CHUNK_EDGES edges and every thread gets at least AUTO_THREAD_EDGES;
+// backends without engines use only those two.
+//
+// The statistics and the choice are cached as <matrix_file>.auto, which is reused while the input (or
+// the binary cache, for graphs that only exist as one) keeps its size and modification time and the graph
+// its vertex and edge counts.
+
+#include <stdbool.h>
+#include "ccgraph.h"
+
+#define AUTO_SAMPLES 4
+#define AUTO_DEEP 64
+#define AUTO_GIANT 0.9
+#define AUTO_CHUNK_EDGES 8192
+#define AUTO_THREAD_EDGES (1 << 16)
+#define AUTO_DEFAULT_LLC (8L << 20)
+
+typedef struct AutoChoice{
+    long long vertices;
+    long long edges;
+    long long source_size;      // the file the graph was read from, to tell a stale .auto
+    long long source_mtime;     // nanoseconds
+    long long max_degree;
+    long long p99_degree;       // power of two at or above 99% of the degrees, from the log2 histogram
+    long long isolated;
+    double avg_degree;
+    vertex_t depth;             // deepest BFS seen, a lower bound on the diameter
+    double giant;               // largest share of the non-isolated vertices one BFS reached
+    char engine[16];
+    int chunk;                  // vertices per sweep chunk
+    int threads;                // from the graph size, the run still uses at most the threads it has
+    char reason[192];
+    double seconds;             // analysis time, 0 when loaded from the cache
+    bool cached;
+}AutoChoice;
+
+bool autoAnalyze(const char* filename, Graph* g, AutoChoice* a); // Fills a from the cache or a fresh pass, false when out of memory
+void autoReport(const char* filename, const AutoChoice* a);      // The "Graph analysis:" line
+
+#endif
@@ -0,0 +1,417 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#define MAX_BACKENDS 16
+#define MAX_THREAD_COUNTS 32
+#define MAX_REPS 1000
+#define MAX_ARGS 32
+
+// Runs every backend executable on every graph and thread count, discards the
+// warm-up runs (the first one also writes the .bin cache), then repeats each
+// configuration and reports min/median/mean/stddev of the kernel time the
+// backend prints. Results are appended to a CSV file and optionally written
+// as JSON, one record per (graph, backend, threads).
+//
+// Thread counts reach the backends through OMP_NUM_THREADS, CILK_NWORKERS and
+// CC_NUM_THREADS; for the MPI backend they are the number of ranks instead.
+// Backends without threads (seq, and a name=path executable whose first run
+// prints no "Threads:" line) run once, whatever the thread counts.
+
+typedef struct Backend{
+    char name[64];
+    char path[256];
+    bool threaded;      // false: run once with a single thread
+    bool mpi;           // launch through $MPIRUN (default mpirun) -np <threads>
+    bool probe;         // name=path: threaded until a run reports no thread count
+}Backend;
+
+typedef struct RunResult{ // Values parsed from one run of a backend
+    double time;        // kernel time reported by the backend
+    double process;     // wall time of the whole process, loading included
+    double vertices;
+    double edges;
+    double components;
+    double iterations;
+    double threads;
+}RunResult;
+
+typedef struct Stats{
+    double min;
+    double median;
+    double mean;
+    double stddev;
+}Stats;
+
+const Backend known_backends[] = {
+    {"seq", "./ccomponents", false, false},
+    {"pthreads", "./ccpthreads", true, false},
+    {"openmp", "./ccopenmp", true, false},
+    {"cilk", "./ccopencilk", true, false},
+    {"mpi", "Homework 2/cc_cilk_mpi", true, true},
+};
+
+double wallTime(){
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+// Reads the number that follows key on the line, if the key is there.
+bool findValue(const char *line, const char *key, double *out){
+
+    const char *p = strstr(line, key);
+
+    if(!p){
+        return false;
+    }
+    p += strlen(key);
+
+    char *end;
+    double val = strtod(p, &end);
+
+    if(end == p){
+        return false;
+    }
+    *out = val;
+    return true;
+}
+
+// The backends do not share one output format, so every spelling is listed.
+void parseLine(const char *line, RunResult *r){
+
+    if(!findValue(line, "Total Vertices:", &r->vertices)){
+        findValue(line, "Nodes:", &r->vertices);
+    }
+    findValue(line, "Edges:", &r->edges);
+    findValue(line, "Components:", &r->components);
+    if(!findValue(line, "Iterations:", &r->iterations)){
+        findValue(line, "Converged in", &r->iterations);
+    }
+    if(!findValue(line, "Time taken:", &r->time)){
+        findValue(line, "Time:", &r->time);
+    }
+    if(!findValue(line, "Threads:", &r->threads)){
+        findValue(line, "Ranks:", &r->threads);
+    }
+}
+
+// Runs the backend once and parses its output. Returns false if it failed or
+// did not report a time; the output is echoed in that case.
+bool runOnce(const Backend *b, const char *graph, int threads, RunResult *r){
+
+    char *args[MAX_ARGS];
+    char np[16];
+    char launcher[512];
+    int argc = 0;
+
+    if(b->mpi){
+        const char *env = getenv("MPIRUN");
+        snprintf(launcher, sizeof(launcher), "%s", env ? env : "mpirun");
+
+        for(char *tok = strtok(launcher, " "); tok && argc < MAX_ARGS - 5; tok = strtok(NULL, " ")){
+            args[argc++] = tok;
+        }
+        snprintf(np, sizeof(np), "%d", threads);
+        args[argc++] = "-np";
+        args[argc++] = np;
+    }
+    args[argc++] = (char*)b->path;
+    args[argc++] = (char*)graph;
+    args[argc] = NULL;
+
+    int fd[2];
+
+    if(pipe(fd) != 0){
+        printf("Failed to create pipe\n");
+        return false;
+    }
+
+    double start_time = wallTime();
+    pid_t pid = fork();
+
+    if(pid < 0){
+        printf("Failed to fork\n");
+        close(fd[0]);
+        close(fd[1]);
+        return false;
+    }
+    if(pid == 0){
+        char count[16];
+        snprintf(count, sizeof(count), "%d", threads);
+
+        if(!b->mpi){ // MPI ranks keep the caller's per-rank worker count
+            setenv("OMP_NUM_THREADS", count, 1);
+            setenv("CILK_NWORKERS", count, 1);
+        }
+        setenv("CC_NUM_THREADS", count, 1);
+        dup2(fd[1], STDOUT_FILENO);
+        dup2(fd[1], STDERR_FILENO);
+        close(fd[0]);
+        close(fd[1]);
+        execvp(args[0], args);
+        dprintf(STDERR_FILENO, "Failed to start %s: %s\n", args[0], strerror(errno)); // stdio buffers die with _exit
+        _exit(127);
+    }
+    close(fd[1]);
+
+    memset(r, 0, sizeof(RunResult));
+    r->time = -1;
+
+    FILE *out = fdopen(fd[0], "r");
+    char output[8192] = "";
+    size_t used = 0;
+    char line[1024];
+
+    while(fgets(line, sizeof(line), out)){
+        parseLine(line, r);
+
+        size_t len = strlen(line);
+        if(used + len < sizeof(output)){
+            memcpy(output + used, line, len + 1);
+            used += len;
+        }
+    }
+    fclose(out);
+
+    int status;
+    waitpid(pid, &status, 0);
+    r->process = wallTime() - start_time;
+
+    if(!WIFEXITED(status) || WEXITSTATUS(status) != 0 || r->time < 0){
+        printf("%s failed on %s with %d threads:\n%s\n", b->name, graph, threads, output);
+        return false;
+    }
+    return true;
+}
+
+int compareDouble(const void *a, const void *b){
+
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+
+    return (x > y) - (x < y);
+}
+
+Stats computeStats(double *vals, int count){
+
+    Stats s;
+    double sum = 0;
+
+    qsort(vals, count, sizeof(double), compareDouble);
+
+    for(int i = 0; i < count; i++){
+        sum += vals[i];
+    }
+    s.min = vals[0];
+    s.mean = sum / count;
+    s.median = (count % 2) ? vals[count / 2] : (vals[count / 2 - 1] + vals[count / 2]) / 2;
+
+    double var = 0;
+
+    for(int i = 0; i < count; i++){
+        var += (vals[i] - s.mean) * (vals[i] - s.mean);
+    }
+    s.stddev = (count > 1) ? sqrt(var / (count - 1)) : 0;
+    return s;
+}
+
+// Accepts a known backend name or name=path for any executable that prints
+// the same lines (e.g. cuda=./cc_v2).
+bool parseBackend(const char *spec, Backend *b){
+
+    const char *eq = strchr(spec, '=');
+
+    if(eq){
+        memset(b, 0, sizeof(Backend));
+        snprintf(b->name, sizeof(b->name), "%.*s", (int)(eq - spec), spec);
+        snprintf(b->path, sizeof(b->path), "%s", eq + 1);
+        b->threaded = true;
+        b->probe = true;
+        return true;
+    }
+    for(size_t i = 0; i < sizeof(known_backends) / sizeof(Backend); i++){
+        if(strcmp(spec, known_backends[i].name) == 0){
+            *b = known_backends[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+int main(int argc, char* argv[]){
+
+    const char *backend_list = "seq,pthreads,openmp,cilk";
+    const char *thread_list = NULL;
+    const char *csv_name = "benchmarks.csv";
+    const char *json_name = NULL;
+    int reps = 5;
+    int warmup = 1;
+    int opt;
+
+    while((opt = getopt(argc, argv, "b:t:r:w:o:j:")) != -1){
+        switch(opt){
+            case 'b': backend_list = optarg; break;
+            case 't': thread_list = optarg; break;
+            case 'r': reps = atoi(optarg); break;
+            case 'w': warmup = atoi(optarg); break;
+            case 'o': csv_name = optarg; break;
+            case 'j': json_name = optarg; break;
+            default: optind = argc + 1; break;
+        }
+    }
+
+    if(optind >= argc || reps < 1 || reps > MAX_REPS || warmup < 0){
+        printf("opening: %s [-b backends] [-t threads] [-r reps] [-w warmup] [-o out.csv] [-j out.json] <graph.mtx> [graph.mtx ...]\n", argv[0]);
+        printf("  backends: comma separated, from seq,pthreads,openmp,cilk,mpi or name=path (default %s)\n", backend_list);
+        printf("  threads: comma separated counts (default: online CPUs), ranks for mpi\n");
+        printf("  reps: measured runs per configuration (default 5, max %d), warmup: discarded runs (default 1)\n", MAX_REPS);
+        return 1;
+    }
+
+    Backend backends[MAX_BACKENDS];
+    int num_backends = 0;
+    char list[1024];
+    snprintf(list, sizeof(list), "%s", backend_list);
+
+    for(char *tok = strtok(list, ","); tok; tok = strtok(NULL, ",")){
+        if(num_backends == MAX_BACKENDS || !parseBackend(tok, &backends[num_backends])){
+            printf("Unknown backend: %s\n", tok);
+            return 1;
+        }
+        num_backends++;
+    }
+
+    int threads[MAX_THREAD_COUNTS];
+    int num_threads = 0;
+
+    if(thread_list){
+        snprintf(list, sizeof(list), "%s", thread_list);
+
+        for(char *tok = strtok(list, ","); tok && num_threads < MAX_THREAD_COUNTS; tok = strtok(NULL, ",")){
+            if(atoi(tok) > 0){
+                threads[num_threads++] = atoi(tok);
+            }
+        }
+    }
+    if(num_threads == 0){
+        threads[num_threads++] = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    }
+
+    struct stat st;
+    bool new_csv = stat(csv_name, &st) != 0 || st.st_size == 0;
+    FILE *csv = fopen(csv_name, "a");
+    FILE *json = json_name ? fopen(json_name, "w") : NULL;
+
+    if(!csv || (json_name && !json)){
+        printf("Failed to open %s\n", !csv ? csv_name : json_name);
+        return 1;
+    }
+    if(new_csv){
+        fprintf(csv, "graph,backend,threads,reported_threads,reps,vertices,edges,components,iterations,"
+                     "time_min,time_median,time_mean,time_stddev,process_median,edges_per_sec\n");
+    }
+    if(json){
+        fprintf(json, "[");
+    }
+
+    double times[MAX_REPS];
+    double process[MAX_REPS];
+    int records = 0;
+    int failures = 0;
+
+    for(int gi = optind; gi < argc; gi++){
+
+        const char *graph = argv[gi];
+        double expected_components = -1;
+
+        for(int bi = 0; bi < num_backends; bi++){
+
+            Backend *b = &backends[bi];
+
+            for(int ti = 0; ti < num_threads; ti++){
+
+                int t = b->threaded ? threads[ti] : 1;
+
+                if(!b->threaded && ti > 0){
+                    break;
+                }
+
+                RunResult r;
+                bool ok = true;
+
+                for(int i = 0; i < warmup && ok; i++){
+                    ok = runOnce(b, graph, t, &r);
+                }
+
+                double iterations = 0;
+
+                for(int i = 0; i < reps && ok; i++){
+                    ok = runOnce(b, graph, t, &r);
+                    times[i] = r.time;
+                    process[i] = r.process;
+                    iterations = r.iterations;
+                }
+
+                if(!ok){
+                    failures++;
+                    continue;
+                }
+                if(b->probe && r.threads == 0){ // prints no thread count, so the other counts would only repeat this run
+                    b->threaded = false;
+                }
+
+                Stats s = computeStats(times, reps);
+                Stats p = computeStats(process, reps);
+                double rate = s.median > 0 ? r.edges / s.median : 0;
+
+                if(expected_components < 0){
+                    expected_components = r.components;
+                }
+                else if(r.components != expected_components){
+                    printf("WARNING: %s found %.0f components on %s, expected %.0f\n", b->name, r.components, graph, expected_components);
+                }
+
+                printf("%s %s threads=%d: median %f s, min %f s, stddev %f s, %.0f iterations, %.3e edges/s\n",
+                       graph, b->name, t, s.median, s.min, s.stddev, iterations, rate);
+
+                fprintf(csv, "%s,%s,%d,%.0f,%d,%.0f,%.0f,%.0f,%.0f,%f,%f,%f,%f,%f,%.0f\n",
+                        graph, b->name, t, r.threads, reps, r.vertices, r.edges, r.components, iterations,
+                        s.min, s.median, s.mean, s.stddev, p.median, rate);
+                fflush(csv);
+
+                if(json){
+                    fprintf(json, "%s\n  {\"graph\": \"%s\", \"backend\": \"%s\", \"path\": \"%s\", \"threads\": %d, "
+                                  "\"reported_threads\": %.0f, \"reps\": %d, \"warmup\": %d, "
+                                  "\"vertices\": %.0f, \"edges\": %.0f, \"components\": %.0f, \"iterations\": %.0f, "
+                                  "\"time\": {\"min\": %f, \"median\": %f, \"mean\": %f, \"stddev\": %f}, "
+                                  "\"process_median\": %f, \"edges_per_sec\": %.0f, \"times\": [",
+                            records ? "," : "", graph, b->name, b->path, t, r.threads, reps, warmup,
+                            r.vertices, r.edges, r.components, iterations,
+                            s.min, s.median, s.mean, s.stddev, p.median, rate);
+
+                    for(int i = 0; i < reps; i++){
+                        fprintf(json, "%s%f", i ? ", " : "", times[i]);
+                    }
+                    fprintf(json, "]}");
+                }
+                records++;
+            }
+        }
+    }
+
+    fclose(csv);
+    if(json){
+        fprintf(json, "\n]\n");
+        fclose(json);
+    }
+    printf("Wrote %d results to %s%s%s\n", records, csv_name, json ? " and " : "", json ? json_name : "");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,483 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <sys/resource.h>
+#include <zlib.h>
+
+#define READ_CHUNK (1 << 22)
+#define MIN_RUN_BUFFER (1 << 16)
+#define MAX_PARTITIONS 512
+
+// Out-of-core CSR construction. The input is streamed three times through a
+// fixed parse buffer:
+//   1. count degrees into offsets (the only O(n) array),
+//   2. bucket every directed edge by source into per-partition run files,
+//      where partitions are vertex ranges whose edges fit in the budget,
+//   3. load one partition at a time, scatter it into its CSR slice, sort and
+//      deduplicate its lists and append the slice to the binary cache.
+// The cache has the same layout as saveBinGraph and is written to a temporary
+// name first, so backends never see a partial file. Offsets are rewritten at
+// the end, once the deduplicated positions are known.
+
+typedef struct Edge{
+    int src;
+    int dst;
+}Edge;
+
+typedef struct Parser{
+    gzFile f;           // zlib passes uncompressed files through, so .mtx and .mtx.gz both work
+    char *buf;
+    size_t carry;
+    long long nnz;
+    long long count;
+    int vertices;
+    char symmetry[64];  // from the banner, reported only: lists are deduplicated either way
+}Parser;
+
+typedef struct Partition{
+    int first;          // first vertex of the range
+    int last;           // one past the last vertex
+    FILE *run;
+    Edge *buf;
+    size_t size;
+    size_t cap;
+}Partition;
+
+double wallTime(){
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+// Parses up to three unsigned integers from a line. Returns how many were read.
+int parseLine(const char *p, const char *end, long long *vals){
+
+    int count = 0;
+
+    while(p < end && count < 3){
+
+        while(p < end && (*p == ' ' || *p == '\t' || *p == '\r')){
+            p++;
+        }
+        if(p == end || *p < '0' || *p > '9'){
+            break;
+        }
+
+        long long val = 0;
+
+        while(p < end && *p >= '0' && *p <= '9'){
+            val = val * 10 + (*p - '0');
+            p++;
+        }
+        vals[count++] = val;
+    }
+    return count;
+}
+
+// Opens the file and reads the MatrixMarket size line.
+bool openParser(Parser *ps, const char *filename){
+
+    ps->f = gzopen(filename, "rb");
+
+    if(!ps->f){
+        return false;
+    }
+    ps->buf = malloc(READ_CHUNK + 1);
+    strcpy(ps->symmetry, "general");
+    ps->carry = 0;
+    ps->count = 0;
+
+    char line[1024];
+    char format[64] = "coordinate";
+
+    while(gzgets(ps->f, line, sizeof(line))){
+        if(strncasecmp(line, "%%MatrixMarket", 14) == 0){ // %%MatrixMarket matrix <format> <field> <symmetry>
+            sscanf(line + 14, "%*s %63s %*s %63s", format, ps->symmetry);
+        }
+        if(line[0] != '%'){
+            break;
+        }
+    }
+
+    long long vals[3];
+
+    if(strcasecmp(format, "coordinate") != 0){
+        printf("Only coordinate MatrixMarket files are supported, %s is %s\n", filename, format);
+        gzclose(ps->f);
+        free(ps->buf);
+        return false;
+    }
+    if(parseLine(line, line + strlen(line), vals) != 3 || !ps->buf){
+        gzclose(ps->f);
+        free(ps->buf);
+        return false;
+    }
+
+    long long n = (vals[0] > vals[1]) ? vals[0] : vals[1];
+
+    if(n > 2147483647LL){
+        printf("Graph has %lld vertices, more than an int vertex id can hold\n", n);
+        exit(1);
+    }
+    ps->vertices = (int)n;
+    ps->nnz = vals[2];
+    return true;
+}
+
+void closeParser(Parser *ps){
+    gzclose(ps->f);
+    free(ps->buf);
+}
+
+// Calls visit(u, v, ctx) for every valid 0-based edge, same filtering as readMTX.
+void forEachEdge(Parser *ps, void (*visit)(int, int, void*), void *ctx){
+
+    z_off_t data_start = gztell(ps->f); // seeking back re-inflates a .gz from the start, one extra decompression per pass
+    int got = 0;
+
+    ps->carry = 0;
+    ps->count = 0;
+
+    while(ps->count < ps->nnz && ((got = gzread(ps->f, ps->buf + ps->carry, READ_CHUNK - ps->carry)) > 0 || (got == 0 && ps->carry > 0))){
+
+        size_t len = ps->carry + got;
+
+        if(got == 0){
+            ps->buf[len++] = '\n';
+        }
+
+        char *p = ps->buf;
+        char *end = ps->buf + len;
+        char *nl;
+
+        while(ps->count < ps->nnz && (nl = memchr(p, '\n', end - p))){
+
+            long long vals[3];
+
+            if(p[0] != '%' && parseLine(p, nl, vals) >= 2){
+
+                long long u = vals[0] - 1;
+                long long v = vals[1] - 1;
+
+                if(u >= 0 && v >= 0 && u < ps->vertices && v < ps->vertices && u != v){
+                    visit((int)u, (int)v, ctx);
+                    ps->count++;
+                }
+            }
+            p = nl + 1;
+        }
+
+        ps->carry = end - p;
+
+        if(ps->count < ps->nnz){
+            memmove(ps->buf, p, ps->carry);
+        }
+    }
+    int err;
+    gzerror(ps->f, &err);
+
+    if(got < 0 || err == Z_BUF_ERROR){
+        printf("Input is truncated or corrupt\n");
+        exit(1);
+    }
+    gzseek(ps->f, data_start, SEEK_SET);
+}
+
+int compareInt(const void *a, const void *b){
+
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+
+    return (x > y) - (x < y);
+}
+
+void countDegree(int u, int v, void *ctx){
+
+    long long *offsets = ctx;
+
+    offsets[u + 1]++;
+    offsets[v + 1]++;
+}
+
+typedef struct Bucketer{
+    Partition *parts;
+    int num_parts;
+    long long written;
+}Bucketer;
+
+int partitionOf(Bucketer *b, int v){
+
+    int lo = 0;
+    int hi = b->num_parts - 1;
+
+    while(lo < hi){
+
+        int mid = (lo + hi + 1) / 2;
+
+        if(b->parts[mid].first <= v){
+            lo = mid;
+        }
+        else{
+            hi = mid - 1;
+        }
+    }
+    return lo;
+}
+
+void flushPartition(Partition *p){
+
+    if(p->size > 0 && fwrite(p->buf, sizeof(Edge), p->size, p->run) != p->size){
+        printf("Failed to write run file\n");
+        exit(1);
+    }
+    p->size = 0;
+}
+
+void pushEdge(Bucketer *b, int src, int dst){
+
+    Partition *p = &b->parts[partitionOf(b, src)];
+
+    p->buf[p->size].src = src;
+    p->buf[p->size].dst = dst;
+
+    if(++p->size == p->cap){
+        flushPartition(p);
+    }
+    b->written++;
+}
+
+void bucketEdge(int u, int v, void *ctx){
+    pushEdge(ctx, u, v);
+    pushEdge(ctx, v, u);
+}
+
+int main(int argc, char* argv[]){
+
+    if(argc < 3){
+        printf("opening: %s <matrix_file.mtx[.gz]> <memory_budget_MB>\n", argv[0]);
+        printf("writes <matrix_file.mtx>.bin for the backends to mmap\n");
+        return 1;
+    }
+
+    long long budget = atoll(argv[2]) * 1024LL * 1024LL;
+    Parser ps;
+
+    if(!openParser(&ps, argv[1])){
+        printf("Failed to load graph from %s\n", argv[1]);
+        return 1;
+    }
+
+    int n = ps.vertices;
+    long long offsets_bytes = (long long)(n + 1) * sizeof(long long);
+    long long fixed_bytes = offsets_bytes + READ_CHUNK;
+
+    if(budget < 2 * fixed_bytes){
+        printf("Budget too small: offsets and parse buffer alone need %.1f MB, give at least %.1f MB\n",
+               fixed_bytes / 1048576.0, 2 * fixed_bytes / 1048576.0);
+        closeParser(&ps);
+        return 1;
+    }
+
+    double start_time = wallTime();
+
+    // Pass 1: degrees
+    long long *offsets = calloc(n + 1, sizeof(long long));
+
+    if(!offsets){
+        printf("NOT ENOUGH MEMORY\n");
+        return 1;
+    }
+    forEachEdge(&ps, countDegree, offsets);
+
+    for(int i = 1; i <= n; i++){
+        offsets[i] += offsets[i - 1];
+    }
+    long long num_edges = offsets[n];
+    double degree_time = wallTime();
+
+    // Half of what is left holds one partition's CSR slice plus its per-vertex
+    // cursors, the other half is shared by the run file write buffers.
+    long long slice_budget = (budget - fixed_bytes) / 2;
+    Partition *parts = calloc(MAX_PARTITIONS, sizeof(Partition));
+    int num_parts = 0;
+    int first = 0;
+
+    while(first < n || num_parts == 0){
+
+        int last = first;
+
+        while(last < n){
+
+            long long edges = offsets[last + 1] - offsets[first];
+            long long bytes = edges * sizeof(int) + (long long)(last + 1 - first) * sizeof(long long);
+
+            if(bytes > slice_budget && last > first){
+                break;
+            }
+            last++;
+        }
+
+        if(num_parts == MAX_PARTITIONS){
+            printf("Budget too small: more than %d partitions needed\n", MAX_PARTITIONS);
+            return 1;
+        }
+        parts[num_parts].first = first;
+        parts[num_parts].last = last;
+        num_parts++;
+        first = last;
+
+        if(n == 0){
+            break;
+        }
+    }
+
+    size_t run_cap = (size_t)((budget - fixed_bytes) / 2 / num_parts / sizeof(Edge));
+
+    if(run_cap * sizeof(Edge) < MIN_RUN_BUFFER){
+        run_cap = MIN_RUN_BUFFER / sizeof(Edge);
+    }
+
+    char bin_name[256];
+    char tmp_name[300];
+    snprintf(bin_name, sizeof(bin_name), "%s.bin", argv[1]);
+    snprintf(tmp_name, sizeof(tmp_name), "%s.tmp", bin_name);
+
+    for(int i = 0; i < num_parts; i++){
+
+        char run_name[320];
+        snprintf(run_name, sizeof(run_name), "%s.run%d", bin_name, i);
+
+        parts[i].run = fopen(run_name, "w+b");
+        parts[i].buf = malloc(run_cap * sizeof(Edge));
+        parts[i].cap = run_cap;
+
+        if(!parts[i].run || !parts[i].buf){
+            printf("Failed to create run file %s\n", run_name);
+            return 1;
+        }
+        remove(run_name); // unlinked now, storage is released when the file is closed
+    }
+
+    // Pass 2: bucket by source
+    Bucketer b = {parts, num_parts, 0};
+    forEachEdge(&ps, bucketEdge, &b);
+
+    for(int i = 0; i < num_parts; i++){
+        flushPartition(&parts[i]);
+        if(i > 0){ // pass 3 only needs one buffer for reading back
+            free(parts[i].buf);
+            parts[i].buf = NULL;
+        }
+    }
+    closeParser(&ps);
+    double bucket_time = wallTime();
+
+    // Pass 3: scatter each partition into its slice and append to the cache
+    FILE *out = fopen(tmp_name, "wb");
+
+    if(!out){
+        printf("Failed to write %s\n", tmp_name);
+        return 1;
+    }
+    fwrite(&n, sizeof(int), 1, out);
+    fwrite(&num_edges, sizeof(long long), 1, out);
+    fwrite(offsets, sizeof(long long), n + 1, out);
+
+    Edge *read_buf = parts[0].buf;
+    long long max_slice = 0;
+    long long kept_edges = 0;
+
+    for(int i = 0; i < num_parts; i++){
+
+        Partition *p = &parts[i];
+        long long base = offsets[p->first];
+        long long slice_edges = offsets[p->last] - base;
+        int *slice = malloc((slice_edges > 0 ? slice_edges : 1) * sizeof(int));
+        long long *cursor = malloc((size_t)(p->last - p->first + 1) * sizeof(long long));
+
+        if(!slice || !cursor){
+            printf("NOT ENOUGH MEMORY\n");
+            return 1;
+        }
+        if(slice_edges > max_slice){
+            max_slice = slice_edges;
+        }
+        for(int v = p->first; v < p->last; v++){
+            cursor[v - p->first] = offsets[v] - base;
+        }
+
+        rewind(p->run);
+        size_t got;
+
+        while((got = fread(read_buf, sizeof(Edge), run_cap, p->run)) > 0){
+            for(size_t k = 0; k < got; k++){
+                slice[cursor[read_buf[k].src - p->first]++] = read_buf[k].dst;
+            }
+        }
+        fclose(p->run);
+
+        // Sort and deduplicate each list, packing the slice in place. offsets of this range now get their
+        // compacted positions; later partitions still read their own, untouched bases.
+        long long kept = 0;
+
+        for(int v = p->first; v < p->last; v++){
+
+            long long start = offsets[v] - base;
+            long long end = offsets[v + 1] - base;
+
+            if(end - start > 1){
+                qsort(slice + start, end - start, sizeof(int), compareInt);
+            }
+            offsets[v] = kept_edges + kept;
+
+            for(long long k = start; k < end; k++){
+                if(k == start || slice[k] != slice[kept - 1]){
+                    slice[kept++] = slice[k];
+                }
+            }
+        }
+        kept_edges += kept;
+
+        if((long long)fwrite(slice, sizeof(int), kept, out) != kept){
+            printf("Failed to write %s\n", tmp_name);
+            return 1;
+        }
+        free(slice);
+        free(cursor);
+    }
+
+    offsets[n] = kept_edges;
+
+    if(fseek(out, sizeof(int), SEEK_SET) != 0
+       || fwrite(&kept_edges, sizeof(long long), 1, out) != 1
+       || (long long)fwrite(offsets, sizeof(long long), n + 1, out) != n + 1){
+        printf("Failed to write %s\n", tmp_name);
+        return 1;
+    }
+    if(fclose(out) != 0 || rename(tmp_name, bin_name) != 0){
+        printf("Failed to write %s\n", bin_name);
+        return 1;
+    }
+    double end_time = wallTime();
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    printf("Saved binary file: %s\n", bin_name);
+    printf("Total Vertices: %d\n", n);
+    printf("Directed edges: %lld in %d partitions (largest slice %lld edges)\n", kept_edges, num_parts, max_slice);
+    printf("MatrixMarket %s: %lld entries, %lld duplicate directed edges removed\n", ps.symmetry, num_edges / 2, num_edges - kept_edges);
+    printf("Time taken: %f seconds (degrees %f, bucket %f, merge %f)\n", end_time - start_time,
+           degree_time - start_time, bucket_time - degree_time, end_time - bucket_time);
+    printf("Memory budget: %.1f MB, peak RSS: %.1f MB, in-memory readMTX would need: %.1f MB\n",
+           budget / 1048576.0, usage.ru_maxrss / 1024.0,
+           (offsets_bytes + num_edges * sizeof(int) + (double)n * 2 * sizeof(int)) / 1048576.0);
+
+    free(read_buf);
+    free(parts);
+    free(offsets);
+    return 0;
+}
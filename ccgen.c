@@ -0,0 +1,441 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <omp.h>
+
+#define RMAT_A 0.57
+#define RMAT_B 0.19
+#define RMAT_C 0.19
+#define RMAT_LEVEL_BITS 16  // each level needs a 16-bit uniform, one hash serves four levels
+#define WRITE_CHUNK (1 << 24)
+
+// Synthetic graph generator that writes the binary cache the backends load
+// (<graph.mtx>.bin), so benchmarks need neither downloads nor text parsing.
+// Every edge is a pure function of (seed, edge index), which makes the output
+// byte-identical for any thread count. Shapes:
+//   rmat        Graph500 Kronecker graph: skewed degrees, one giant component
+//   grid        2D 4-neighbour grid: diameter rows + cols
+//   path        a single path: diameter n - 1, the worst case for propagation
+//   star        one hub adjacent to every other vertex
+//   components  many small random trees
+
+typedef struct Generator{
+    int type;
+    int vertices;
+    long long edges;    // undirected edges before self loops are dropped
+    long long p1;
+    long long p2;
+    uint64_t seed;
+}Generator;
+
+enum { GEN_RMAT, GEN_GRID, GEN_PATH, GEN_STAR, GEN_COMPONENTS };
+
+static inline uint64_t mix64(uint64_t x){ // splitmix64 finaliser
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+
+// Produces undirected edge i. Returns false for a self loop.
+bool makeEdge(const Generator *gen, long long i, int *u, int *v){
+
+    uint64_t state = gen->seed ^ mix64((uint64_t)i);
+
+    switch(gen->type){
+
+        case GEN_RMAT:{
+            const uint32_t ta = (uint32_t)(RMAT_A * (1 << RMAT_LEVEL_BITS));
+            const uint32_t tab = (uint32_t)((RMAT_A + RMAT_B) * (1 << RMAT_LEVEL_BITS));
+            const uint32_t tabc = (uint32_t)((RMAT_A + RMAT_B + RMAT_C) * (1 << RMAT_LEVEL_BITS));
+            int scale = (int)gen->p1;
+            uint64_t mask = ((uint64_t)1 << scale) - 1;
+            uint64_t x = 0, y = 0;
+            uint64_t bits = 0;
+
+            for(int level = 0; level < scale; level++){
+                if(level % (64 / RMAT_LEVEL_BITS) == 0){
+                    state = mix64(state);
+                    bits = state;
+                }
+                uint32_t r = (uint32_t)(bits & ((1 << RMAT_LEVEL_BITS) - 1));
+                bits >>= RMAT_LEVEL_BITS;
+
+                int bit_x = r >= tab;
+                int bit_y = (r >= ta && r < tab) || r >= tabc;
+
+                x = (x << 1) | bit_x;
+                y = (y << 1) | bit_y;
+            }
+            // odd multiplier is a bijection mod 2^scale, spreads the hubs away from vertex 0
+            uint64_t scramble = mix64(gen->seed) | 1;
+            *u = (int)((x * scramble) & mask);
+            *v = (int)((y * scramble) & mask);
+            break;
+        }
+        case GEN_GRID:{
+            long long rows = gen->p1;
+            long long cols = gen->p2;
+            long long horizontal = rows * (cols - 1);
+
+            if(i < horizontal){
+                long long cell = (i / (cols - 1)) * cols + i % (cols - 1);
+                *u = (int)cell;
+                *v = (int)(cell + 1);
+            }
+            else{
+                *u = (int)(i - horizontal);
+                *v = (int)(i - horizontal + cols);
+            }
+            break;
+        }
+        case GEN_PATH:
+            *u = (int)i;
+            *v = (int)(i + 1);
+            break;
+
+        case GEN_STAR:
+            *u = 0;
+            *v = (int)(i + 1);
+            break;
+
+        case GEN_COMPONENTS:{ // vertex j of each tree links to a random earlier vertex of the same tree
+            long long size = gen->p2;
+            long long comp = i / (size - 1);
+            long long j = i % (size - 1) + 1;
+
+            *u = (int)(comp * size + j);
+            *v = (int)(comp * size + (long long)(mix64(state) % (uint64_t)j));
+            break;
+        }
+    }
+    return *u != *v;
+}
+
+int compareInt(const void *a, const void *b){
+
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+
+    return (x > y) - (x < y);
+}
+
+// Parallel exclusive prefix sum of offsets[1..n] in place, one block per thread.
+void prefixSum(long long *offsets, int n){
+
+    int nthreads = omp_get_max_threads();
+    long long *block_sum = calloc(nthreads + 1, sizeof(long long));
+
+    #pragma omp parallel
+    {
+        int t = omp_get_thread_num();
+        int threads = omp_get_num_threads();
+        long long lo = 1 + (long long)n * t / threads;
+        long long hi = 1 + (long long)n * (t + 1) / threads;
+        long long sum = 0;
+
+        for(long long i = lo; i < hi; i++){
+            sum += offsets[i];
+            offsets[i] = sum;
+        }
+        block_sum[t + 1] = sum;
+
+        #pragma omp barrier
+        #pragma omp single
+        for(int i = 1; i <= threads; i++){
+            block_sum[i] += block_sum[i - 1];
+        }
+
+        for(long long i = lo; i < hi; i++){
+            offsets[i] += block_sum[t];
+        }
+    }
+    free(block_sum);
+}
+
+bool parseType(const char *name, int *type){
+
+    const char *names[] = {"rmat", "grid", "path", "star", "components"};
+
+    for(int i = 0; i < 5; i++){
+        if(strcmp(name, names[i]) == 0){
+            *type = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Fills in vertices and edges from the shape parameters.
+bool sizeGraph(Generator *gen){
+
+    long long n = 0;
+    long long m = 0;
+
+    switch(gen->type){
+        case GEN_RMAT: // p1 = scale, p2 = edge factor
+            if(gen->p1 < 1 || gen->p1 > 30 || gen->p2 < 1){
+                return false;
+            }
+            n = 1LL << gen->p1;
+            m = n * gen->p2;
+            break;
+        case GEN_GRID: // p1 x p2
+            if(gen->p1 < 1 || gen->p2 < 1){
+                return false;
+            }
+            n = gen->p1 * gen->p2;
+            m = gen->p1 * (gen->p2 - 1) + (gen->p1 - 1) * gen->p2;
+            break;
+        case GEN_PATH:
+        case GEN_STAR:
+            if(gen->p1 < 1){
+                return false;
+            }
+            n = gen->p1;
+            m = n - 1;
+            break;
+        case GEN_COMPONENTS: // p1 components of p2 vertices
+            if(gen->p1 < 1 || gen->p2 < 1){
+                return false;
+            }
+            n = gen->p1 * gen->p2;
+            m = gen->p1 * (gen->p2 - 1);
+            break;
+    }
+    if(n > 2147483647LL){
+        printf("Graph has %lld vertices, more than an int vertex id can hold\n", n);
+        exit(1);
+    }
+    gen->vertices = (int)n;
+    gen->edges = m;
+    return true;
+}
+
+bool writeMTX(const char *filename, const Generator *gen, const long long *offsets, const int *edges){ // self loops were already dropped
+
+    FILE *f = fopen(filename, "w");
+
+    if(!f){
+        return false;
+    }
+    fprintf(f, "%%%%MatrixMarket matrix coordinate pattern symmetric\n");
+    fprintf(f, "%d %d %lld\n", gen->vertices, gen->vertices, offsets[gen->vertices] / 2);
+
+    for(int v = 0; v < gen->vertices; v++){ // lower triangle, each edge once
+        for(long long k = offsets[v]; k < offsets[v + 1]; k++){
+            if(edges[k] < v){
+                fprintf(f, "%d %d\n", v + 1, edges[k] + 1);
+            }
+        }
+    }
+    return fclose(f) == 0;
+}
+
+int main(int argc, char* argv[]){
+
+    if(argc < 4){
+        printf("opening: %s <type> <graph.mtx> <p1> [p2] [--seed S] [--mtx]\n", argv[0]);
+        printf("  rmat <scale> <edge_factor>   2^scale vertices, edge_factor * 2^scale edges\n");
+        printf("  grid <rows> <cols>\n");
+        printf("  path <n>\n");
+        printf("  star <n>\n");
+        printf("  components <count> <size>    count random trees of size vertices\n");
+        printf("writes <graph.mtx>.bin for the backends; --mtx also writes <graph.mtx>\n");
+        return 1;
+    }
+
+    Generator gen = {0};
+    bool write_mtx = false;
+    int params = 0;
+
+    gen.seed = 1;
+
+    if(!parseType(argv[1], &gen.type)){
+        printf("Unknown graph type: %s\n", argv[1]);
+        return 1;
+    }
+    for(int i = 3; i < argc; i++){
+        if(strcmp(argv[i], "--seed") == 0 && i + 1 < argc){
+            gen.seed = strtoull(argv[++i], NULL, 10);
+        }
+        else if(strcmp(argv[i], "--mtx") == 0){
+            write_mtx = true;
+        }
+        else if(params == 0){
+            gen.p1 = atoll(argv[i]);
+            params++;
+        }
+        else if(params == 1){
+            gen.p2 = atoll(argv[i]);
+            params++;
+        }
+    }
+    if(!sizeGraph(&gen)){
+        printf("Invalid parameters for %s\n", argv[1]);
+        return 1;
+    }
+
+    int n = gen.vertices;
+    long long m = gen.edges;
+    double start_time = omp_get_wtime();
+
+    // Generate the edge list
+    int *src = malloc((m > 0 ? m : 1) * sizeof(int));
+    int *dst = malloc((m > 0 ? m : 1) * sizeof(int));
+    long long *offsets = calloc((size_t)n + 1, sizeof(long long));
+
+    if(!src || !dst || !offsets){
+        printf("NOT ENOUGH MEMORY\n");
+        return 1;
+    }
+
+    #pragma omp parallel for schedule(static)
+    for(long long i = 0; i < m; i++){
+        int u, v;
+
+        if(makeEdge(&gen, i, &u, &v)){
+            src[i] = u;
+            dst[i] = v;
+            #pragma omp atomic
+            offsets[u + 1]++;
+            #pragma omp atomic
+            offsets[v + 1]++;
+        }
+        else{
+            src[i] = -1;
+        }
+    }
+    double gen_time = omp_get_wtime();
+
+    // Build the CSR: prefix sum, scatter, then sort each list so the bytes do
+    // not depend on the scatter order and drop the repeated edges RMAT draws
+    prefixSum(offsets, n);
+
+    long long num_edges = offsets[n];
+    int *edges = malloc((num_edges > 0 ? num_edges : 1) * sizeof(int));
+    long long *cursor = malloc((size_t)n * sizeof(long long));
+
+    if(!edges || !cursor){
+        printf("NOT ENOUGH MEMORY\n");
+        return 1;
+    }
+
+    #pragma omp parallel for
+    for(int i = 0; i < n; i++){
+        cursor[i] = offsets[i];
+    }
+
+    #pragma omp parallel for schedule(static)
+    for(long long i = 0; i < m; i++){
+        if(src[i] < 0){
+            continue;
+        }
+        long long pu, pv;
+        #pragma omp atomic capture
+        pu = cursor[src[i]]++;
+        #pragma omp atomic capture
+        pv = cursor[dst[i]]++;
+        edges[pu] = dst[i];
+        edges[pv] = src[i];
+    }
+    free(src);
+    free(dst);
+    free(cursor);
+
+    long long *kept = calloc((size_t)n + 1, sizeof(long long));
+
+    if(!kept){
+        printf("NOT ENOUGH MEMORY\n");
+        return 1;
+    }
+
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for(int v = 0; v < n; v++){
+        int *list = edges + offsets[v];
+        long long deg = offsets[v + 1] - offsets[v];
+        long long unique = (deg > 0) ? 1 : 0;
+
+        if(deg > 1){
+            qsort(list, deg, sizeof(int), compareInt);
+        }
+        for(long long k = 1; k < deg; k++){
+            if(list[k] != list[unique - 1]){
+                list[unique++] = list[k];
+            }
+        }
+        kept[v + 1] = unique;
+    }
+    prefixSum(kept, n);
+
+    long long generated = num_edges;
+    int *packed = malloc((kept[n] > 0 ? kept[n] : 1) * sizeof(int));
+
+    if(!packed){
+        printf("NOT ENOUGH MEMORY\n");
+        return 1;
+    }
+
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for(int v = 0; v < n; v++){
+        memcpy(packed + kept[v], edges + offsets[v], (kept[v + 1] - kept[v]) * sizeof(int));
+    }
+    free(edges);
+    free(offsets);
+    edges = packed;
+    offsets = kept;
+    num_edges = kept[n];
+    double csr_time = omp_get_wtime();
+
+    // Write the binary cache, same layout as saveBinGraph
+    char bin_name[256];
+    char tmp_name[300];
+    snprintf(bin_name, sizeof(bin_name), "%s.bin", argv[2]);
+    snprintf(tmp_name, sizeof(tmp_name), "%s.tmp", bin_name);
+
+    FILE *f = fopen(tmp_name, "wb");
+
+    if(!f){
+        printf("Failed to write %s\n", tmp_name);
+        return 1;
+    }
+    setvbuf(f, NULL, _IOFBF, WRITE_CHUNK);
+
+    bool ok = fwrite(&n, sizeof(int), 1, f) == 1
+           && fwrite(&num_edges, sizeof(long long), 1, f) == 1
+           && fwrite(offsets, sizeof(long long), (size_t)n + 1, f) == (size_t)n + 1
+           && (long long)fwrite(edges, sizeof(int), num_edges, f) == num_edges;
+
+    if(fclose(f) != 0 || !ok || rename(tmp_name, bin_name) != 0){
+        printf("Failed to write %s\n", bin_name);
+        remove(tmp_name);
+        return 1;
+    }
+    double end_time = omp_get_wtime();
+
+    double bytes = sizeof(int) + sizeof(long long) + ((double)n + 1) * sizeof(long long) + (double)num_edges * sizeof(int);
+
+    printf("Saved binary file: %s\n", bin_name);
+    printf("Total Vertices: %d\n", n);
+    printf("Total Edges: %lld\n", num_edges);
+    printf("Duplicate directed edges removed: %lld\n", generated - num_edges);
+    printf("Time taken: %f seconds (generate %f, csr %f, write %f)\n", end_time - start_time,
+           gen_time - start_time, csr_time - gen_time, end_time - csr_time);
+    printf("Output: %.1f MB at %.2f GB/s end to end\n", bytes / 1e6,
+           end_time > start_time ? bytes / (end_time - start_time) / 1e9 : 0.0);
+
+    if(write_mtx){
+        if(!writeMTX(argv[2], &gen, offsets, edges)){
+            printf("Failed to write %s\n", argv[2]);
+            return 1;
+        }
+        printf("Saved matrix file: %s\n", argv[2]);
+    }
+
+    free(edges);
+    free(offsets);
+    return 0;
+}
@@ -0,0 +1,1243 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <zlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include "ccgraph.h"
+#include "ccinput.h"
+#include "ccparallel.h"
+
+Pipeline *pipeline = NULL;
+
+#ifdef CC_TRACE
+const char* phase_names[NUM_PHASES] = {"load_cache", "parse", "csr_build", "cache_write", "compute", "stats"};
+
+Trace trace = {{0}, NULL, 0, 0, 1};
+
+double traceTime(){
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+TraceIteration *traceIteration(){ // Appends an empty record for the next iteration
+
+    if(trace.count == trace.cap){
+        trace.cap = trace.cap ? 2 * trace.cap : 64;
+        trace.iters = realloc(trace.iters, trace.cap * sizeof(TraceIteration));
+    }
+    TraceIteration *it = &trace.iters[trace.count++];
+
+    it->time = 0;
+    it->changed = 0;
+    it->edges = 0;
+    it->busy = calloc(trace.threads, sizeof(double));
+    return it;
+}
+
+void traceWrite(const char* filename, const char* backend, long long vertices, long long edges){
+
+    char name[512];
+    snprintf(name, sizeof(name), "%s.trace.json", filename);
+
+    FILE* f = fopen(name, "w");
+
+    if(!f){
+        printf("Failed to write %s\n", name);
+        return;
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    fprintf(f, "{\n  \"backend\": \"%s\", \"graph\": \"%s\", \"vertices\": %lld, \"edges\": %lld, \"threads\": %d,\n",
+            backend, filename, vertices, edges, trace.threads);
+    fprintf(f, "  \"peak_rss_mb\": %.2f,\n  \"phases\": {", usage.ru_maxrss / 1024.0);
+    for(int i = 0; i < NUM_PHASES; i++){
+        fprintf(f, "%s\"%s\": %f", i ? ", " : "", phase_names[i], trace.phase[i]);
+    }
+    fprintf(f, "},\n  \"iterations\": [");
+
+    for(int i = 0; i < trace.count; i++){
+
+        TraceIteration *it = &trace.iters[i];
+
+        fprintf(f, "%s\n    {\"time\": %f, \"changed\": %lld, \"edges_scanned\": %lld, \"edges_per_sec\": %.0f, \"busy\": [",
+                i ? "," : "", it->time, it->changed, it->edges, it->time > 0 ? it->edges / it->time : 0.0);
+        for(int t = 0; t < trace.threads; t++){
+            fprintf(f, "%s%f", t ? ", " : "", it->busy[t]);
+        }
+        fprintf(f, "], \"idle\": [");
+        for(int t = 0; t < trace.threads; t++){
+            fprintf(f, "%s%f", t ? ", " : "", it->time > it->busy[t] ? it->time - it->busy[t] : 0.0);
+        }
+        fprintf(f, "]}");
+        free(it->busy);
+    }
+    fprintf(f, "\n  ]\n}\n");
+    fclose(f);
+    free(trace.iters);
+    trace.iters = NULL;
+    trace.count = 0;
+    trace.cap = 0;
+    printf("Saved trace file: %s\n", name);
+}
+#endif
+
+double wallTime(){
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+void saveBinGraph(Graph* g, const char* filename) {
+
+    FILE* f = fopen(filename, "wb");
+
+    if (!f){
+        return;
+    }
+    fwrite(&g->vertices, sizeof(vertex_t), 1, f);
+    fwrite(&g->num_edges, sizeof(long long), 1, f);
+
+    long long chunk[4096];
+
+    for (long long i = 0; i <= g->vertices; i += 4096) {
+        int count = (g->vertices + 1 - i < 4096) ? (int)(g->vertices + 1 - i) : 4096;
+        for (int j = 0; j < count; j++) {
+            chunk[j] = g->offsets[i + j];
+        }
+        fwrite(chunk, sizeof(long long), count, f);
+    }
+    fwrite(g->edges, sizeof(vertex_t), g->num_edges, f);
+    fclose(f);
+    printf("Saved binary file: %s\n", filename);
+}
+
+void *cacheWriter(void *arg){
+
+    CacheWriter *w = (CacheWriter*)arg;
+    double start = wallTime();
+
+    saveBinGraph(w->g, w->name);
+    w->seconds = wallTime() - start;
+    return NULL;
+}
+
+void cacheWriteStart(CacheWriter *w, Graph *g, const char* filename){
+
+    w->g = g;
+    snprintf(w->name, sizeof(w->name), "%s", filename);
+    w->seconds = 0;
+    w->running = pthread_create(&w->thread, NULL, cacheWriter, w) == 0;
+
+    if(!w->running){
+        cacheWriter(w);
+    }
+}
+
+void cacheWriteWait(CacheWriter *w){
+
+    if(w->running){
+        pthread_join(w->thread, NULL);
+        w->running = false;
+    }
+}
+
+vertex_t pipelineFind(vertex_t *parent, vertex_t x){
+
+    while(parent[x] != x){
+        parent[x] = parent[parent[x]]; // path halving
+        x = parent[x];
+    }
+    return x;
+}
+
+bool pipelineGrow(Pipeline *p, vertex_t v){ // Makes v a vertex of the forest
+
+    if(v < p->capacity){
+        return true;
+    }
+    long long capacity = p->capacity ? p->capacity : (1 << 20);
+
+    while(capacity <= v){
+        capacity *= 2;
+    }
+    vertex_t *grown = realloc(p->parent, capacity * sizeof(vertex_t));
+
+    if(!grown){
+        return false;
+    }
+    for(long long i = p->capacity; i < capacity; i++){
+        grown[i] = i;
+    }
+    p->parent = grown;
+    p->capacity = capacity;
+    return true;
+}
+
+void *pipelineConsumer(void *arg){
+
+    Pipeline *p = (Pipeline*)arg;
+    long long consumed = 0;
+
+    while(true){
+
+        pthread_mutex_lock(&p->lock);
+        while(consumed == p->published && !p->done){
+            pthread_cond_wait(&p->ready, &p->lock);
+        }
+        long long upto = p->published;
+        pthread_mutex_unlock(&p->lock);
+
+        if(consumed == upto){ // done and drained
+            break;
+        }
+        double start = wallTime();
+
+        pthread_rwlock_rdlock(&p->grow);
+        for(; consumed < upto && !p->failed; consumed++){
+
+            vertex_t u = p->pairs[2 * consumed];
+            vertex_t v = p->pairs[2 * consumed + 1];
+
+            if(!pipelineGrow(p, (u > v) ? u : v)){
+                p->failed = true;
+                break;
+            }
+            vertex_t ru = pipelineFind(p->parent, u);
+            vertex_t rv = pipelineFind(p->parent, v);
+
+            if(ru != rv){
+                p->parent[(ru > rv) ? ru : rv] = (ru < rv) ? ru : rv;
+                p->unions++;
+            }
+        }
+        pthread_rwlock_unlock(&p->grow);
+        consumed = upto;
+        p->busy += wallTime() - start;
+    }
+    return NULL;
+}
+
+bool pipelineStart(Pipeline *p){
+
+    memset(p, 0, sizeof(Pipeline));
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->ready, NULL);
+    pthread_rwlock_init(&p->grow, NULL);
+    return pthread_create(&p->thread, NULL, pipelineConsumer, p) == 0;
+}
+
+void pipelinePublish(Pipeline *p, long long count, bool done){
+
+    pthread_mutex_lock(&p->lock);
+    p->published = count;
+    p->done = done;
+    pthread_cond_signal(&p->ready);
+    pthread_mutex_unlock(&p->lock);
+}
+
+void pipelineStop(Pipeline *p, long long count){
+
+    pipelinePublish(p, count, true);
+    pthread_join(p->thread, NULL);
+    pthread_mutex_destroy(&p->lock);
+    pthread_cond_destroy(&p->ready);
+    pthread_rwlock_destroy(&p->grow);
+}
+
+bool pipelineSeed(Pipeline *p, Graph *g){
+
+    bool seeded = !p->failed;
+
+    for(vertex_t v = 0; seeded && v < g->vertices; v++){
+        g->labels[v] = (v < p->capacity) ? pipelineFind(p->parent, v) : v;
+    }
+    free(p->parent);
+    p->parent = NULL;
+    return seeded;
+}
+
+void pipelineReport(const Pipeline *p, const CacheWriter *w, bool parsed){
+
+    if(!parsed){
+        printf("Pipeline: graph loaded from the cache, nothing to overlap\n");
+    }
+    else if(p->failed){
+        printf("Pipeline: union-find stopped (out of memory), labels not seeded; cache written in the background in %f seconds\n", w->seconds);
+    }
+    else{
+        printf("Pipeline: %lld unions alongside the parse (%f seconds busy) gave the final labels, sweeps skipped; cache written in the background in %f seconds\n",
+               p->unions, p->busy, w->seconds);
+    }
+}
+
+void initLabels(void *arg, long long begin, long long end){
+
+    vertex_t *labels = (vertex_t*)arg;
+
+    for(long long i = begin; i < end; i++){
+        labels[i] = i;
+    }
+}
+
+Graph * createGraph(vertex_t vertices, long long edge_capacity){
+
+    Graph* g = malloc(sizeof(Graph));
+
+    if(!g){
+        return NULL;
+    }
+    g->vertices = vertices;
+    g->num_edges = 0;
+    g->edges = NULL;
+
+    size_t bytes = (size_t)(vertices + 1) * sizeof(edge_t) + (size_t)vertices * sizeof(vertex_t)
+                 + (size_t)edge_capacity * sizeof(vertex_t) + 3 * CACHE_LINE;
+
+    if(!arenaReuse(&g->arena, bytes) && !arenaCreate(&g->arena, bytes)){
+        free(g);
+        return NULL;
+    }
+    g->offsets = arenaAlloc(&g->arena, (vertices + 1) * sizeof(edge_t));
+    g->labels = arenaAlloc(&g->arena, vertices * sizeof(vertex_t));
+    arenaTouch(g->offsets, (vertices + 1) * sizeof(edge_t));
+    parallelFor(vertices, 1, initLabels, g->labels); // first touch by the threads that sweep them
+    return g;
+}
+
+void freeGraph(Graph* g){
+
+    if(!g){
+        return;
+    }
+    arenaFree(&g->arena);
+    free(g);
+}
+
+typedef struct DiskOffsets{
+    const char *disk;   // 64-bit and only 4-byte aligned in the file
+    edge_t *offsets;
+}DiskOffsets;
+
+void copyOffsets(void *arg, long long begin, long long end){
+
+    DiskOffsets *d = (DiskOffsets*)arg;
+
+    for(long long i = begin; i < end; i++){
+        long long offset;
+        memcpy(&offset, d->disk + i * sizeof(long long), sizeof(long long));
+        d->offsets[i] = (edge_t)offset;
+    }
+}
+
+Graph* loadBinGraph(const char* filename) {
+    int fd = open(filename, O_RDONLY);
+
+    if (fd == -1) {
+        return NULL;
+    }
+
+    struct stat st;
+    vertex_t n;
+    long long num_edges;
+
+    if (fstat(fd, &st) == -1 || st.st_size < (off_t)(sizeof(vertex_t) + sizeof(long long))) {
+        close(fd);
+        return NULL;
+    }
+
+    char* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (map == MAP_FAILED) {
+        return NULL;
+    }
+    memcpy(&n, map, sizeof(vertex_t));
+    memcpy(&num_edges, map + sizeof(vertex_t), sizeof(long long));
+
+    size_t header = sizeof(vertex_t) + sizeof(long long) + (size_t)(n + 1) * sizeof(long long);
+
+    if (n < 0 || num_edges < 0 || (unsigned long long)num_edges > EDGE_MAX || (size_t)st.st_size < header + (size_t)num_edges * sizeof(vertex_t)) {
+        munmap(map, st.st_size);
+        return NULL;
+    }
+
+    Graph* g = createGraph(n, 0);
+
+    if (!g) {
+        munmap(map, st.st_size);
+        return NULL;
+    }
+    DiskOffsets d = {map + sizeof(vertex_t) + sizeof(long long), g->offsets};
+
+    g->num_edges = num_edges;
+    parallelFor((long long)n + 1, 1, copyOffsets, &d);
+    g->edges = (vertex_t*)(map + header);
+    arenaAdopt(&g->arena, map, st.st_size);
+    return g;
+}
+
+typedef struct Scan{
+    edge_t *a;
+    vertex_t n;
+    int blocks;
+    edge_t *sums;       // sums[b + 1]: the total of block b, then the total of the blocks before it
+}Scan;
+
+void scanBlock(void *arg, long long begin, long long end){ // Each block sums its own range of a[1..n]
+
+    Scan *s = (Scan*)arg;
+
+    for(long long b = begin; b < end; b++){
+        vertex_t lo = 1 + (long long)s->n * b / s->blocks;
+        vertex_t hi = 1 + (long long)s->n * (b + 1) / s->blocks;
+        edge_t sum = 0;
+
+        for(vertex_t i = lo; i < hi; i++){
+            sum += s->a[i];
+            s->a[i] = sum;
+        }
+        s->sums[b + 1] = sum;
+    }
+}
+
+void shiftBlock(void *arg, long long begin, long long end){
+
+    Scan *s = (Scan*)arg;
+
+    for(long long b = begin; b < end; b++){
+        vertex_t lo = 1 + (long long)s->n * b / s->blocks;
+        vertex_t hi = 1 + (long long)s->n * (b + 1) / s->blocks;
+
+        for(vertex_t i = lo; i < hi; i++){
+            s->a[i] += s->sums[b];
+        }
+    }
+}
+
+void prefixSum(edge_t *a, vertex_t n){ // a[1..n] in place, a[0] stays 0
+
+    Scan s = {a, n, (parallel.threads > 1) ? parallel.threads : 1, NULL};
+
+    s.sums = (s.blocks > 1) ? calloc(s.blocks + 1, sizeof(edge_t)) : NULL;
+
+    if(!s.sums){
+        for(vertex_t i = 1; i <= n; i++){
+            a[i] += a[i - 1];
+        }
+        return;
+    }
+    parallelFor(s.blocks, 1, scanBlock, &s);
+    for(int b = 1; b <= s.blocks; b++){
+        s.sums[b] += s.sums[b - 1];
+    }
+    parallelFor(s.blocks, 1, shiftBlock, &s);
+    free(s.sums);
+}
+
+int compareVertex(const void *a, const void *b){
+    vertex_t x = *(const vertex_t*)a;
+    vertex_t y = *(const vertex_t*)b;
+    return (x > y) - (x < y);
+}
+
+// Parallel CSR build from parsed (u, v) pairs, one contiguous block of pairs per worker. When a degree
+// histogram per block costs no more than the pairs themselves, every block counts into its own histogram,
+// which then becomes its private cursor into each list, so the scatter needs no atomics. Otherwise degrees
+// and cursors are shared and bumped atomically. Either way every list is then sorted and deduplicated, so
+// the result does not depend on the path taken or the number of workers.
+typedef struct Build{ // buildCSR state shared by its parallel loops
+    Graph *g;
+    vertex_t *pairs;
+    long long count;
+    int blocks;
+    edge_t *hist;       // blocks rows of n degree counts, then where each block starts inside every list
+    edge_t *cursor;     // without hist: the next free slot of every list, claimed atomically
+    edge_t *kept;       // unique neighbours per list, for the dedup
+}Build;
+
+void countBlock(void *arg, long long begin, long long end){
+
+    Build *b = (Build*)arg;
+    vertex_t n = b->g->vertices;
+
+    for(long long k = begin; k < end; k++){
+        edge_t *h = b->hist + (size_t)k * n;
+
+        for(long long i = b->count * k / b->blocks; i < b->count * (k + 1) / b->blocks; i++){
+            h[b->pairs[2 * i]]++;
+            h[b->pairs[2 * i + 1]]++;
+        }
+    }
+}
+
+void blockStarts(void *arg, long long begin, long long end){ // Per-block counts become per-block start positions inside each list
+
+    Build *b = (Build*)arg;
+    vertex_t n = b->g->vertices;
+
+    for(long long v = begin; v < end; v++){
+        edge_t sum = 0;
+
+        for(int k = 0; k < b->blocks; k++){
+            edge_t c = b->hist[(size_t)k * n + v];
+            b->hist[(size_t)k * n + v] = sum;
+            sum += c;
+        }
+        b->g->offsets[v + 1] = sum;
+    }
+}
+
+void countAtomic(void *arg, long long begin, long long end){
+
+    Build *b = (Build*)arg;
+
+    for(long long i = begin; i < end; i++){
+        __atomic_fetch_add(&b->g->offsets[b->pairs[2 * i] + 1], 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&b->g->offsets[b->pairs[2 * i + 1] + 1], 1, __ATOMIC_RELAXED);
+    }
+}
+
+void scatterBlock(void *arg, long long begin, long long end){
+
+    Build *b = (Build*)arg;
+    vertex_t n = b->g->vertices;
+    edge_t *offsets = b->g->offsets;
+    vertex_t *edges = b->g->edges;
+
+    for(long long k = begin; k < end; k++){
+        edge_t *next = b->hist + (size_t)k * n;
+
+        for(long long i = b->count * k / b->blocks; i < b->count * (k + 1) / b->blocks; i++){
+            vertex_t u = b->pairs[2 * i];
+            vertex_t v = b->pairs[2 * i + 1];
+
+            edges[offsets[u] + next[u]++] = v;
+            edges[offsets[v] + next[v]++] = u;
+        }
+    }
+}
+
+void startCursors(void *arg, long long begin, long long end){
+
+    Build *b = (Build*)arg;
+
+    memcpy(b->cursor + begin, b->g->offsets + begin, (end - begin) * sizeof(edge_t));
+}
+
+void scatterAtomic(void *arg, long long begin, long long end){
+
+    Build *b = (Build*)arg;
+    vertex_t *edges = b->g->edges;
+
+    for(long long i = begin; i < end; i++){
+        vertex_t u = b->pairs[2 * i];
+        vertex_t v = b->pairs[2 * i + 1];
+
+        edges[__atomic_fetch_add(&b->cursor[u], 1, __ATOMIC_RELAXED)] = v;
+        edges[__atomic_fetch_add(&b->cursor[v], 1, __ATOMIC_RELAXED)] = u;
+    }
+}
+
+void uniqueLists(void *arg, long long begin, long long end){ // Sorts every list and keeps its distinct neighbours at its front
+
+    Build *b = (Build*)arg;
+
+    for(long long v = begin; v < end; v++){
+        vertex_t *list = b->g->edges + b->g->offsets[v];
+        edge_t deg = b->g->offsets[v + 1] - b->g->offsets[v];
+        edge_t unique = (deg > 0) ? 1 : 0;
+
+        if(deg > 1){
+            qsort(list, deg, sizeof(vertex_t), compareVertex);
+        }
+        for(edge_t k = 1; k < deg; k++){
+            if(list[k] != list[unique - 1]){
+                list[unique++] = list[k];
+            }
+        }
+        b->kept[v + 1] = unique;
+    }
+}
+
+void packLists(void *arg, long long begin, long long end){
+
+    Build *b = (Build*)arg;
+
+    for(long long v = begin; v < end; v++){
+        memcpy(b->pairs + b->kept[v], b->g->edges + b->g->offsets[v], (b->kept[v + 1] - b->kept[v]) * sizeof(vertex_t));
+    }
+}
+
+void keptOffsets(void *arg, long long begin, long long end){
+
+    Build *b = (Build*)arg;
+
+    memcpy(b->g->offsets + begin, b->kept + begin, (end - begin) * sizeof(edge_t));
+}
+
+void unpackEdges(void *arg, long long begin, long long end){
+
+    Build *b = (Build*)arg;
+
+    memcpy(b->g->edges + begin, b->pairs + begin, (end - begin) * sizeof(vertex_t));
+}
+
+bool buildCSR(Graph* g, vertex_t *pairs, long long count){ // pairs is reused as scratch
+
+    vertex_t n = g->vertices;
+    edge_t *offsets = g->offsets; // offsets[v + 1] collects the degree of v, the arena hands it out zeroed
+    Build b = {g, pairs, count, (parallel.threads > 1) ? parallel.threads : 1, NULL, NULL, NULL};
+
+    b.kept = malloc(((size_t)n + 1) * sizeof(edge_t));
+
+    if((long long)b.blocks * n <= 2 * count){
+        b.hist = calloc((size_t)b.blocks * n, sizeof(edge_t));
+    }
+    if(!b.hist){
+        b.cursor = malloc((n > 0 ? n : 1) * sizeof(edge_t));
+    }
+    if(!b.kept || (!b.hist && !b.cursor)){ // every scratch buffer is taken before any work, so one failure frees them all
+        free(b.kept);
+        free(b.hist);
+        free(b.cursor);
+        return false;
+    }
+
+    if(b.hist){
+        parallelFor(b.blocks, 1, countBlock, &b);
+        parallelFor(n, 1, blockStarts, &b);
+    }
+    else{
+        parallelFor(count, 1, countAtomic, &b);
+    }
+    prefixSum(offsets, n);
+
+    g->num_edges = offsets[n];
+    g->edges = arenaAlloc(&g->arena, g->num_edges * sizeof(vertex_t));
+
+    if(!g->edges){
+        free(b.kept);
+        free(b.hist);
+        free(b.cursor);
+        return false;
+    }
+    arenaTouch(g->edges, g->num_edges * sizeof(vertex_t));
+
+    if(b.hist){
+        parallelFor(b.blocks, 1, scatterBlock, &b);
+        free(b.hist);
+    }
+    else{
+        parallelFor(n, 1, startCursors, &b);
+        parallelFor(count, 1, scatterAtomic, &b);
+        free(b.cursor);
+    }
+
+    // Sort every list and drop repeated neighbors: general-format files list both (u, v) and (v, u), which
+    // would otherwise store every edge twice. The unique lists are packed into pairs, no longer needed and
+    // exactly as long as edges, then copied back.
+    b.kept[0] = 0;
+    parallelFor(n, 16, uniqueLists, &b);
+    prefixSum(b.kept, n);
+    parallelFor(n, 16, packLists, &b);
+    parallelFor((long long)n + 1, 1, keptOffsets, &b);
+    g->num_edges = offsets[n];
+    parallelFor(g->num_edges, 1, unpackEdges, &b);
+    arenaTrim(&g->arena, g->edges, g->num_edges * sizeof(vertex_t));
+    free(b.kept);
+    return true;
+}
+
+const char *wider_build = NULL;
+
+void tooWide(long long vertices){ // Reports a graph this build cannot hold and notes the one that can
+
+    printf("Graph does not fit the %d-bit vertex / %d-bit edge build\n", CC_VERTEX_BITS, CC_EDGE_BITS);
+#if CC_VERTEX_BITS == 32
+    wider_build = (vertices > VERTEX_MAX) ? "_v64" : "_e64";
+#else
+    (void)vertices;
+#endif
+}
+
+typedef struct EdgeList{
+    vertex_t *pairs;        // (u, v) in file order, 0-based, self loops dropped
+    long long count;
+    vertex_t vertices;
+    char kind[160];         // "MatrixMarket coordinate symmetric", "SNAP edge list", ...
+}EdgeList;
+
+// MatrixMarket files and SNAP-style edge lists, read and classified by ccinput.c like ccstream does.
+bool readEdges(const char* filename, EdgeList *el){
+
+    Input in;
+
+    if(!inputOpen(&in, filename)){
+        return false;
+    }
+
+    char line[1024];
+    EdgeFormat fmt;
+    bool ok = true;
+    long long nnz = -1; // from the size line, stays -1 for edge lists
+    long long n = 0;
+    long long capacity = 0;
+
+    edgeFormatInit(&fmt, filename);
+
+    el->pairs = NULL;
+    el->count = 0;
+
+    bool piped = pipeline && pipelineStart(pipeline);
+
+    while(ok && (nnz < 0 || el->count < nnz) && inputGets(&in, line, sizeof(line))){
+
+        long long u, v;
+        int kind = edgeFormatLine(&fmt, line, &u, &v);
+
+        if(kind == LINE_SIZE || kind == LINE_BAD_SIZE){
+
+            long long rows = fmt.rows;
+            long long cols = fmt.cols;
+
+            if(strcasecmp(fmt.format, "coordinate") != 0){
+                printf("Only coordinate MatrixMarket files are supported, %s is %s\n", filename, fmt.format);
+                ok = false;
+            }
+            else if(kind == LINE_BAD_SIZE){
+                printf("Failed to read the size line of %s\n", filename);
+                ok = false;
+            }
+            else if(((rows > cols) ? rows : cols) > VERTEX_MAX || 2 * fmt.nnz > (long long)EDGE_MAX){
+                tooWide((rows > cols) ? rows : cols);
+                ok = false;
+            }
+            else{
+                n = (rows > cols) ? rows : cols;
+                nnz = fmt.nnz;
+                capacity = (nnz > 0) ? nnz : 1;
+                el->pairs = malloc(2 * capacity * sizeof(vertex_t));
+                ok = el->pairs != NULL;
+
+                if(piped){
+                    pipeline->pairs = el->pairs;
+                }
+            }
+            continue;
+        }
+        if(kind != LINE_EDGE){
+            continue;
+        }
+        if(!fmt.mtx){
+            if(u >= VERTEX_MAX || v >= VERTEX_MAX){
+                tooWide((u > v) ? u + 1 : v + 1);
+                ok = false;
+                continue;
+            }
+            n = (u >= n) ? u + 1 : n;
+            n = (v >= n) ? v + 1 : n;
+        }
+        if(u == v){
+            continue;
+        }
+        if(2 * (el->count + 1) > (long long)EDGE_MAX){ // stop before the pairs outgrow the offsets
+            tooWide(n);
+            ok = false;
+            continue;
+        }
+        if(el->count == capacity){ // edge lists do not announce their size
+
+            capacity = capacity ? 2 * capacity : (1 << 20);
+
+            if(piped){ // realloc may move the array the consumer is reading
+                pthread_rwlock_wrlock(&pipeline->grow);
+            }
+            vertex_t *grown = realloc(el->pairs, 2 * capacity * sizeof(vertex_t));
+
+            if(piped){
+                pipeline->pairs = grown ? grown : el->pairs;
+                pthread_rwlock_unlock(&pipeline->grow);
+            }
+
+            if(!grown){
+                ok = false;
+                continue;
+            }
+            el->pairs = grown;
+        }
+        el->pairs[2 * el->count] = u;
+        el->pairs[2 * el->count + 1] = v;
+        el->count++;
+
+        if(piped && el->count % PIPE_BATCH == 0){
+            pipelinePublish(pipeline, el->count, false);
+        }
+    }
+    if(piped){
+        pipelineStop(pipeline, el->count);
+    }
+    else if(pipeline){
+        pipeline->failed = true;
+    }
+
+    if(!inputClose(&in)){
+        printf("%s is truncated or corrupt\n", filename);
+        ok = false;
+    }
+    if(ok && fmt.mtx && nnz < 0){
+        printf("Failed to read the size line of %s\n", filename);
+        ok = false;
+    }
+    if(!ok){
+        free(el->pairs);
+        return false;
+    }
+    el->vertices = (vertex_t)n;
+
+    if(fmt.mtx){
+        snprintf(el->kind, sizeof(el->kind), "MatrixMarket %s %s", fmt.format, fmt.symmetry);
+    }
+    else{
+        snprintf(el->kind, sizeof(el->kind), "SNAP edge list");
+    }
+    return true;
+}
+
+Graph *readMTX(const char* filename){
+
+    EdgeList el;
+    TRACE(double parse_start = traceTime());
+
+    if(!readEdges(filename, &el)){
+        return NULL;
+    }
+    TRACE(trace.phase[PHASE_PARSE] = traceTime() - parse_start);
+
+    Graph *g = createGraph(el.vertices, 2 * el.count);
+
+    if(!g || !buildCSR(g, el.pairs, el.count)){
+        printf("NOT ENOUGH MEMORY (build the cache out of core with: ccbuild %s <memory_MB>)\n", filename);
+        free(el.pairs);
+        freeGraph(g);
+        return NULL;
+    }
+    TRACE(trace.phase[PHASE_CSR_BUILD] = traceTime() - parse_start - trace.phase[PHASE_PARSE]);
+    printf("%s: %lld entries, %lld duplicate directed edges removed\n", el.kind, el.count, 2 * el.count - g->num_edges);
+    free(el.pairs);
+    return g;
+}
+
+// Component sizes are counted with atomic adds into c->sizes, except for the first STATS_PRIVATE ids, which
+// every block counts privately and adds once. Ids follow the roots and a root is its component's smallest
+// vertex, so the large components get the small ids and the shared counters mostly see the small ones.
+#define STATS_PRIVATE 4096
+
+typedef struct Stats{ // computeComponents state shared by its parallel loops
+    const Graph *g;
+    Components *c;
+    int blocks;
+    vertex_t *root_count;   // root_count[b + 1]: the roots in block b, then the roots before it
+    vertex_t private_ids;
+}Stats;
+
+void countRoots(void *arg, long long begin, long long end){
+
+    Stats *s = (Stats*)arg;
+    vertex_t n = s->g->vertices;
+
+    for(long long b = begin; b < end; b++){
+        vertex_t lo = (long long)n * b / s->blocks;
+        vertex_t hi = (long long)n * (b + 1) / s->blocks;
+        vertex_t local = 0;
+
+        for(vertex_t v = lo; v < hi; v++){
+            if(s->g->labels[v] == v){
+                local++;
+            }
+        }
+        s->root_count[b + 1] = local;
+    }
+}
+
+void numberRoots(void *arg, long long begin, long long end){
+
+    Stats *s = (Stats*)arg;
+    vertex_t n = s->g->vertices;
+
+    for(long long b = begin; b < end; b++){
+        vertex_t lo = (long long)n * b / s->blocks;
+        vertex_t hi = (long long)n * (b + 1) / s->blocks;
+        vertex_t id = s->root_count[b];
+
+        for(vertex_t v = lo; v < hi; v++){
+            if(s->g->labels[v] == v){
+                s->c->comp[v] = id;
+                s->c->roots[id++] = v;
+            }
+        }
+    }
+}
+
+void countSizes(void *arg, long long begin, long long end){
+
+    Stats *s = (Stats*)arg;
+    vertex_t n = s->g->vertices;
+    vertex_t *labels = s->g->labels;
+    Components *c = s->c;
+
+    for(long long b = begin; b < end; b++){
+        vertex_t lo = (long long)n * b / s->blocks;
+        vertex_t hi = (long long)n * (b + 1) / s->blocks;
+        vertex_t *hist = calloc(s->private_ids > 0 ? s->private_ids : 1, sizeof(vertex_t));
+
+        if(!hist){
+            printf("NOT ENOUGH MEMORY\n");
+            exit(1);
+        }
+        for(vertex_t v = lo; v < hi; v++){
+            if(labels[v] != v){
+                c->comp[v] = c->comp[labels[v]]; // the root's id is set by numberRoots
+            }
+            if(c->comp[v] < s->private_ids){
+                hist[c->comp[v]]++;
+            }
+            else if(s->blocks == 1){ // nothing to share the counters with
+                c->sizes[c->comp[v]]++;
+            }
+            else{
+                __atomic_fetch_add(&c->sizes[c->comp[v]], 1, __ATOMIC_RELAXED);
+            }
+        }
+        for(vertex_t i = 0; i < s->private_ids; i++){
+            if(hist[i]){
+                __atomic_fetch_add(&c->sizes[i], hist[i], __ATOMIC_RELAXED);
+            }
+        }
+        free(hist);
+    }
+}
+
+Components *computeComponents(Graph* g){
+
+    Components *c = malloc(sizeof(Components));
+    Stats s = {g, c, (parallel.threads > 1) ? parallel.threads : 1, NULL, 0};
+
+    s.root_count = calloc(s.blocks + 1, sizeof(vertex_t));
+
+    if(!c || !s.root_count){
+        printf("NOT ENOUGH MEMORY\n");
+        exit(1);
+    }
+    c->comp = malloc(g->vertices * sizeof(vertex_t));
+
+    parallelFor(s.blocks, 1, countRoots, &s);
+    for(int b = 1; b <= s.blocks; b++){
+        s.root_count[b] += s.root_count[b - 1];
+    }
+    c->count = s.root_count[s.blocks];
+    c->roots = malloc(c->count * sizeof(vertex_t));
+    c->sizes = calloc(c->count, sizeof(vertex_t));
+
+    parallelFor(s.blocks, 1, numberRoots, &s);
+    if(s.blocks > 1){
+        s.private_ids = (c->count < STATS_PRIVATE) ? c->count : STATS_PRIVATE;
+    }
+    parallelFor(s.blocks, 1, countSizes, &s);
+    free(s.root_count);
+    return c;
+}
+
+void freeComponents(Components* c){
+
+    if(!c){
+        return;
+    }
+    free(c->comp);
+    free(c->roots);
+    free(c->sizes);
+    free(c);
+}
+
+void saveComponents(Graph* g, Components* c, const char* filename, bool csv){
+
+    char name[512];
+    char tmp_name[520];
+    snprintf(name, sizeof(name), "%s.labels", filename);
+    snprintf(tmp_name, sizeof(tmp_name), "%s.tmp", name); // renamed into place so a live mmap never sees a partial file
+
+    FILE* f = fopen(tmp_name, "wb");
+
+    if(!f){
+        printf("Failed to write %s\n", name);
+        return;
+    }
+    fwrite(LABELS_MAGIC, 1, 4, f);
+    fwrite(&g->vertices, sizeof(vertex_t), 1, f);
+    fwrite(&c->count, sizeof(vertex_t), 1, f);
+    fwrite(g->labels, sizeof(vertex_t), g->vertices, f);
+    fwrite(c->comp, sizeof(vertex_t), g->vertices, f);
+    fwrite(c->roots, sizeof(vertex_t), c->count, f);
+    fwrite(c->sizes, sizeof(vertex_t), c->count, f);
+    fclose(f);
+    rename(tmp_name, name);
+    printf("Saved labels file: %s\n", name);
+
+    if(!csv){
+        return;
+    }
+
+    snprintf(name, sizeof(name), "%s.labels.csv", filename);
+    f = fopen(name, "w");
+
+    if(!f){
+        printf("Failed to write %s\n", name);
+        return;
+    }
+    fprintf(f, "vertex,label,component\n");
+    for(vertex_t i = 0; i < g->vertices; i++){
+        fprintf(f, "%lld,%lld,%lld\n", (long long)i, (long long)g->labels[i], (long long)c->comp[i]);
+    }
+    fclose(f);
+
+    snprintf(name, sizeof(name), "%s.components.csv", filename);
+    f = fopen(name, "w");
+
+    if(!f){
+        printf("Failed to write %s\n", name);
+        return;
+    }
+    fprintf(f, "component,root,size\n");
+    for(vertex_t i = 0; i < c->count; i++){
+        fprintf(f, "%lld,%lld,%lld\n", (long long)i, (long long)c->roots[i], (long long)c->sizes[i]);
+    }
+    fclose(f);
+    printf("Saved CSV files: %s.labels.csv, %s.components.csv\n", filename, filename);
+}
+
+bool peekGraphSize(const char* filename, long long* n, long long* m){
+
+    char bin_name[256];
+    snprintf(bin_name, sizeof(bin_name), "%s.bin", filename);
+
+    FILE* f = fopen(bin_name, "rb");
+
+    if(f){
+        int32_t n32;
+        long long m64;
+        bool ok = fread(&n32, sizeof(int32_t), 1, f) == 1 && fread(&m64, sizeof(long long), 1, f) == 1;
+
+        fclose(f);
+        if(ok){
+            *n = n32;
+            *m = m64;
+            return true;
+        }
+    }
+
+    gzFile gz = gzopen(filename, "rb"); // plain or gzip'd
+
+    if(!gz){
+        return false;
+    }
+
+    char line[1024] = "";
+    long long rows, cols, nnz;
+    bool mtx = strstr(filename, ".mtx") != NULL;
+
+    while(gzgets(gz, line, sizeof(line))){
+        if(strncasecmp(line, "%%MatrixMarket", 14) == 0){
+            mtx = true;
+        }
+        if(line[0] != '%'){
+            break;
+        }
+    }
+    gzclose(gz);
+
+    if(!mtx || sscanf(line, "%lld %lld %lld", &rows, &cols, &nnz) != 3){ // edge lists and archives are sized while parsing
+        return false;
+    }
+    *n = (rows > cols) ? rows : cols;
+    *m = 2 * nnz; // upper bound, self loops are dropped later
+    return true;
+}
+
+const char *buildFor(const char* filename, long long* n, long long* m){
+#if CC_VERTEX_BITS == 32
+    if(!peekGraphSize(filename, n, m)){
+        return NULL;
+    }
+    if(*n > VERTEX_MAX){
+        return "_v64";
+    }
+    if(*m > (long long)EDGE_MAX){
+        return "_e64";
+    }
+#else
+    (void)filename;
+    (void)n;
+    (void)m;
+#endif
+    return NULL;
+}
+
+void execBuild(char* argv[], const char* suffix){
+
+    char path[512];
+    size_t len = strlen(argv[0]);
+
+    if(len > 4 && strcmp(argv[0] + len - 4, "_e64") == 0){
+        len -= 4;
+    }
+    snprintf(path, sizeof(path), "%.*s%s", (int)len, argv[0], suffix);
+    printf("Switching to %s\n", path);
+    fflush(stdout);
+    execv(path, argv);
+    printf("Failed to start %s (build it with make)\n", path);
+    exit(1);
+}
+
+void selectBuild(char* argv[]){
+
+    long long n, m;
+    const char* suffix = buildFor(argv[1], &n, &m);
+
+    if(suffix){
+        printf("Graph has %lld vertices and up to %lld edges\n", n, m);
+        execBuild(argv, suffix);
+    }
+}
+
+#define PREFETCH_CHUNK (1 << 20)
+
+bool batchInput(const char* name){
+
+    const char* exts[] = {".mtx", ".mtx.gz", ".txt", ".txt.gz", ".el", ".el.gz", ".tar.gz", ".tgz"};
+    size_t len = strlen(name);
+
+    for(size_t i = 0; i < sizeof(exts) / sizeof(exts[0]); i++){
+        size_t ext = strlen(exts[i]);
+
+        if(len > ext && strcmp(name + len - ext, exts[i]) == 0){
+            return true;
+        }
+    }
+    return false;
+}
+
+int compareName(const void *a, const void *b){
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+char **batchList(const char* path, int* count){
+
+    struct stat st;
+    char **names = NULL;
+    int cap = 0;
+    char name[4096];
+
+    *count = 0;
+
+    if(stat(path, &st) != 0){
+        return NULL;
+    }
+    if(S_ISDIR(st.st_mode)){
+
+        DIR *dir = opendir(path);
+        struct dirent *entry;
+
+        if(!dir){
+            return NULL;
+        }
+        while((entry = readdir(dir))){
+            if(entry->d_name[0] == '.' || !batchInput(entry->d_name)){
+                continue;
+            }
+            if(*count == cap){
+                cap = cap ? 2 * cap : 64;
+                names = realloc(names, cap * sizeof(char*));
+            }
+            snprintf(name, sizeof(name), "%s/%s", path, entry->d_name);
+            names[(*count)++] = strdup(name);
+        }
+        closedir(dir);
+        qsort(names, *count, sizeof(char*), compareName);
+        return names ? names : malloc(sizeof(char*));
+    }
+
+    FILE* f = fopen(path, "r");
+
+    if(!f){
+        return NULL;
+    }
+    while(fgets(name, sizeof(name), f)){
+
+        char *p = name;
+        size_t len;
+
+        while(*p == ' ' || *p == '\t'){
+            p++;
+        }
+        len = strlen(p);
+        while(len > 0 && (p[len - 1] == '\n' || p[len - 1] == '\r' || p[len - 1] == ' ' || p[len - 1] == '\t')){
+            p[--len] = '\0';
+        }
+        if(len == 0 || p[0] == '#'){
+            continue;
+        }
+        if(*count == cap){
+            cap = cap ? 2 * cap : 64;
+            names = realloc(names, cap * sizeof(char*));
+        }
+        names[(*count)++] = strdup(p);
+    }
+    fclose(f);
+    return names ? names : malloc(sizeof(char*));
+}
+
+void *prefetchReader(void *arg){ // Reads a file once so its pages are cached when the main thread maps or parses it
+    Prefetch *p = (Prefetch*)arg;
+    int fd = open(p->name, O_RDONLY);
+
+    if(fd == -1){
+        return NULL;
+    }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+
+    char *buf = malloc(PREFETCH_CHUNK);
+
+    while(buf && read(fd, buf, PREFETCH_CHUNK) > 0){
+    }
+    free(buf);
+    close(fd);
+    return NULL;
+}
+
+void prefetchStart(Prefetch *p, const char* filename){
+
+    struct stat st;
+
+    snprintf(p->name, sizeof(p->name), "%s" BIN_SUFFIX, filename);
+    if(stat(p->name, &st) != 0){
+        snprintf(p->name, sizeof(p->name), "%s", filename);
+    }
+    p->running = pthread_create(&p->thread, NULL, prefetchReader, p) == 0;
+}
+
+void prefetchWait(Prefetch *p){
+
+    if(p->running){
+        pthread_join(p->thread, NULL);
+        p->running = false;
+    }
+}
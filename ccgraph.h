@@ -0,0 +1,184 @@
+#ifndef CCGRAPH_H
+#define CCGRAPH_H
+
+// The CSR graph and what every backend does with it outside the kernels: reading MatrixMarket, SNAP and
+// archive inputs into CSR, the binary cache, the background cache writer, the --pipeline union-find,
+// component output, traces and the batch file list. Loops go through the backend's parallel hook
+// (ccparallel.h), so each backend only keeps its kernel, its component statistics and main.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "ccarena.h"
+
+// Index widths are fixed at compile time so no kernel branches on them:
+//   default               32-bit vertex ids, 32-bit edge offsets
+//   -DCC_EDGE_BITS=64     32-bit vertex ids, 64-bit edge offsets (the _e64 build)
+//   -DCC_VERTEX_BITS=64   64-bit vertex ids and offsets, .bin64 cache (the _v64 build)
+// main() reads the graph size first and execs the narrowest build that fits. ccgraph.c is compiled once per
+// width (ccgraph.o, ccgraph_e64.o, ccgraph_v64.o) and each build links the matching object.
+#ifndef CC_VERTEX_BITS
+#define CC_VERTEX_BITS 32
+#endif
+#ifndef CC_EDGE_BITS
+#define CC_EDGE_BITS CC_VERTEX_BITS
+#endif
+#if CC_VERTEX_BITS == 64 && CC_EDGE_BITS != 64
+#error "64-bit vertex ids need 64-bit edge offsets"
+#endif
+
+#if CC_VERTEX_BITS == 64
+typedef int64_t vertex_t;
+#define VERTEX_MAX INT64_MAX
+#define BIN_SUFFIX ".bin64"
+#define LABELS_MAGIC "CCL2"
+#else
+typedef int32_t vertex_t;
+#define VERTEX_MAX INT32_MAX
+#define BIN_SUFFIX ".bin"
+#define LABELS_MAGIC "CCL1"
+#endif
+
+#if CC_EDGE_BITS == 64
+typedef int64_t edge_t;
+#define EDGE_MAX INT64_MAX
+#else
+typedef uint32_t edge_t;
+#define EDGE_MAX UINT32_MAX
+#endif
+
+typedef struct Graph{
+    vertex_t vertices;
+    long long num_edges;
+    vertex_t *edges;
+    edge_t *offsets;
+    vertex_t *labels;
+    Arena arena; // offsets, labels and parsed edges
+}Graph;
+
+typedef struct Components{ // Per-vertex compacted component ids and per-component sizes
+    vertex_t count;
+    vertex_t *comp;
+    vertex_t *roots;
+    vertex_t *sizes;
+}Components;
+
+#ifdef CC_TRACE
+// Instrumented build (make TRACE=1): phase timings, peak RSS and per-iteration
+// wall time, labels changed, edges scanned and per-thread busy time are kept
+// here and written to <matrix_file.mtx>.trace.json. In normal builds every
+// TRACE() statement compiles away.
+#define TRACE(...) __VA_ARGS__
+
+enum { PHASE_LOAD_CACHE, PHASE_PARSE, PHASE_CSR_BUILD, PHASE_CACHE_WRITE, PHASE_COMPUTE, PHASE_STATS, NUM_PHASES };
+
+typedef struct TraceIteration{
+    double time;
+    long long changed;
+    long long edges;
+    double *busy;       // seconds each thread spent scanning, the rest of time is idle
+}TraceIteration;
+
+typedef struct Trace{
+    double phase[NUM_PHASES];
+    TraceIteration *iters;
+    int count;
+    int cap;
+    int threads;
+}Trace;
+
+extern Trace trace;
+
+double traceTime();
+TraceIteration *traceIteration(); // Appends an empty record for the next iteration
+void traceWrite(const char* filename, const char* backend, long long vertices, long long edges);
+#else
+#define TRACE(...)
+#endif
+
+Graph * createGraph(vertex_t vertices, long long edge_capacity); // edge_capacity: directed edges to reserve, 0 when they stay in a mapped cache
+void freeGraph(Graph* g);
+Graph* loadBinGraph(const char* filename); // Map the binary cache: edges are used in place, offsets are copied
+Graph *readMTX(const char* filename); // MatrixMarket or SNAP edge list, plain, .gz or a SuiteSparse .tar.gz
+Components *computeComponents(Graph* g); // Compact labels into 0..count-1 and count component sizes, over the parallel hook
+void freeComponents(Components* c);
+void saveComponents(Graph* g, Components* c, const char* filename, bool csv); // Write labels, compacted ids and sizes
+
+double wallTime();
+
+void saveBinGraph(Graph* g, const char* filename); // Offsets are always stored as 64-bit on disk
+
+// Background cache write (--pipeline): the binary cache is saved by its own thread while the graph computes.
+// saveBinGraph only reads offsets and edges and the sweeps only write labels, so nothing is shared that
+// either side changes; the graph is freed only after cacheWriteWait.
+typedef struct CacheWriter{
+    Graph *g;
+    char name[256];
+    double seconds;
+    bool running;
+    pthread_t thread;
+}CacheWriter;
+
+void cacheWriteStart(CacheWriter *w, Graph *g, const char* filename); // Falls back to a synchronous write without a thread
+void cacheWriteWait(CacheWriter *w);
+
+// Pipelined ingest (--pipeline). A union-find thread follows the parser through the pair array, taking the
+// pairs PIPE_BATCH at a time as they are published, so connectivity is settled by the time the last line is
+// read. The forest links under the smaller root, leaving every root the minimum id of its component, and
+// pipelineSeed writes those roots as the final labels, so a seeded graph skips the sweeps entirely. Edge
+// lists grow the pair array with realloc, so the parser takes the grow lock for that while the consumer holds
+// it for reading around each batch.
+#define PIPE_BATCH 65536
+
+typedef struct Pipeline{
+    const vertex_t *pairs;      // the parser's array, replaced under grow when realloc moves it
+    long long published;        // pairs the consumer may read
+    bool done;                  // the parser has published its last pair
+    bool failed;                // the forest could not grow, labels are not seeded
+    vertex_t *parent;           // union-find forest over the ids seen so far
+    long long capacity;
+    long long unions;
+    double busy;                // seconds the consumer spent on unions
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+    pthread_rwlock_t grow;
+}Pipeline;
+
+extern Pipeline *pipeline; // set by --pipeline, readEdges then runs the consumer alongside the parse
+
+bool pipelineStart(Pipeline *p);
+void pipelinePublish(Pipeline *p, long long count, bool done);
+void pipelineStop(Pipeline *p, long long count); // Publishes the last pairs and waits until they are joined
+
+// labels[v] = the root of v, which is the final label, then the forest is released. False when the forest
+// could not be built; the labels must then be computed by the sweeps.
+bool pipelineSeed(Pipeline *p, Graph *g);
+void pipelineReport(const Pipeline *p, const CacheWriter *w, bool parsed);
+
+// Index widths: main() calls selectBuild first, which re-execs the _e64 or _v64 build when the graph does
+// not fit this one; batch mode asks buildFor, which names that build or returns NULL when this one fits.
+// Only the binary cache and MatrixMarket headers give the size up front. Edge lists and archives are sized
+// while parsing, so when readMTX fails because the graph outgrew this build it leaves the suffix of the
+// build that fits in wider_build, and main() re-execs with execBuild.
+extern const char *wider_build;
+
+bool peekGraphSize(const char* filename, long long* n, long long* m); // Vertex and directed edge counts without loading the graph
+const char *buildFor(const char* filename, long long* n, long long* m);
+void selectBuild(char* argv[]);
+void execBuild(char* argv[], const char* suffix); // Does not return
+
+// Batch mode: the graph inputs to run, and a reader thread that pulls the next one into the page cache
+bool batchInput(const char* name); // Graph inputs by extension, skipping caches, labels and traces
+char **batchList(const char* path, int* count); // Sorted graph paths of a directory, or the lines of a manifest
+
+typedef struct Prefetch{
+    pthread_t thread;
+    char name[512];
+    bool running;
+}Prefetch;
+
+void prefetchStart(Prefetch *p, const char* filename);
+void prefetchWait(Prefetch *p);
+
+#endif
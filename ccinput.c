@@ -0,0 +1,276 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include "ccinput.h"
+
+void *inputReader(void *arg){
+
+    Input *in = (Input*)arg;
+
+    while(true){
+
+        pthread_mutex_lock(&in->lock);
+        while(in->ready == READ_BUFFERS && !in->stop){
+            pthread_cond_wait(&in->drained, &in->lock);
+        }
+        int slot = in->tail;
+        bool stop = in->stop;
+        pthread_mutex_unlock(&in->lock);
+
+        int want = (in->remaining >= 0 && in->remaining < READ_CHUNK) ? (int)in->remaining : READ_CHUNK;
+        int got = (stop || want == 0) ? 0 : gzread(in->gz, in->buf[slot], want);
+        int err = Z_OK;
+
+        if(got <= 0 && !stop){
+            gzerror(in->gz, &err);
+        }
+
+        pthread_mutex_lock(&in->lock);
+        if(got > 0){
+            in->len[slot] = got;
+            in->tail = (slot + 1) % READ_BUFFERS;
+            in->ready++;
+            if(in->remaining >= 0){
+                in->remaining -= got;
+            }
+        }
+        else{
+            in->done = true;
+            in->error = !stop && (got < 0 || err == Z_BUF_ERROR || in->remaining > 0);
+        }
+        pthread_cond_signal(&in->filled);
+        pthread_mutex_unlock(&in->lock);
+
+        if(got <= 0){
+            return NULL;
+        }
+    }
+}
+
+bool inputTarMember(Input *in, const char *filename){
+
+    char header[TAR_BLOCK];
+
+    while(gzread(in->gz, header, TAR_BLOCK) == TAR_BLOCK && header[0] != '\0'){
+
+        char name[101];
+        char size_field[13];
+
+        memcpy(name, header, 100);
+        name[100] = '\0';
+        memcpy(size_field, header + 124, 12);
+        size_field[12] = '\0';
+
+        long long size = strtoll(size_field, NULL, 8);
+        const char *base = strrchr(name, '/');
+        size_t dir_len = base ? (size_t)(base - name) : 0;
+        size_t base_len;
+
+        base = base ? base + 1 : name;
+        base_len = strlen(base);
+
+        bool regular = header[156] == '0' || header[156] == '\0';
+        bool matrix = regular && base_len > 4 && strcmp(base + base_len - 4, ".mtx") == 0
+                   && (dir_len == 0 || (base_len == dir_len + 4 && strncmp(base, name, dir_len) == 0));
+
+        if(matrix){
+            in->remaining = size;
+            return true;
+        }
+        if(gzseek(in->gz, (size + TAR_BLOCK - 1) / TAR_BLOCK * TAR_BLOCK, SEEK_CUR) < 0){
+            break;
+        }
+    }
+    printf("No matrix (D/D.mtx) found in archive %s\n", filename);
+    return false;
+}
+
+bool inputOpen(Input *in, const char *filename){
+
+    memset(in, 0, sizeof(Input));
+    in->remaining = -1;
+    in->gz = gzopen(filename, "rb");
+
+    if(!in->gz){
+        return false;
+    }
+    gzbuffer(in->gz, 1 << 20);
+
+    size_t len = strlen(filename);
+    bool tar = (len > 7 && strcmp(filename + len - 7, ".tar.gz") == 0) || (len > 4 && strcmp(filename + len - 4, ".tgz") == 0);
+
+    if(tar && !inputTarMember(in, filename)){
+        gzclose(in->gz);
+        return false;
+    }
+    for(int i = 0; i < READ_BUFFERS; i++){
+        in->buf[i] = malloc(READ_CHUNK);
+
+        if(!in->buf[i]){
+            printf("NOT ENOUGH MEMORY\n");
+            exit(1);
+        }
+    }
+    pthread_mutex_init(&in->lock, NULL);
+    pthread_cond_init(&in->filled, NULL);
+    pthread_cond_init(&in->drained, NULL);
+    pthread_create(&in->reader, NULL, inputReader, in);
+    return true;
+}
+
+bool inputNext(Input *in){
+
+    pthread_mutex_lock(&in->lock);
+
+    if(in->cur){
+        in->head = (in->head + 1) % READ_BUFFERS;
+        in->ready--;
+        in->cur = NULL;
+        pthread_cond_signal(&in->drained);
+    }
+    while(in->ready == 0 && !in->done){
+        pthread_cond_wait(&in->filled, &in->lock);
+    }
+    if(in->ready > 0){
+        in->cur = in->buf[in->head];
+        in->pos = 0;
+        in->bytes += in->len[in->head];
+    }
+    pthread_mutex_unlock(&in->lock);
+    return in->cur != NULL;
+}
+
+char *inputGets(Input *in, char *line, int size){ // fgets over the chunk stream, lines may span chunks
+
+    int n = 0;
+
+    while(n < size - 1){
+
+        if(!in->cur || in->pos == in->len[in->head]){
+            if(!inputNext(in)){
+                break;
+            }
+        }
+
+        size_t avail = in->len[in->head] - in->pos;
+        size_t room = (size_t)(size - 1 - n);
+        char *start = in->cur + in->pos;
+        char *nl = memchr(start, '\n', (avail < room) ? avail : room);
+        size_t take = nl ? (size_t)(nl - start) + 1 : ((avail < room) ? avail : room);
+
+        memcpy(line + n, start, take);
+        in->pos += take;
+        n += take;
+
+        if(nl){
+            break;
+        }
+    }
+    if(n == 0){
+        return NULL;
+    }
+    line[n] = '\0';
+    return line;
+}
+
+bool inputClose(Input *in){
+
+    pthread_mutex_lock(&in->lock);
+    in->stop = true;
+    pthread_cond_signal(&in->drained);
+    pthread_mutex_unlock(&in->lock);
+    pthread_join(in->reader, NULL);
+
+    bool ok = !in->error;
+
+    gzclose(in->gz);
+    for(int i = 0; i < READ_BUFFERS; i++){
+        free(in->buf[i]);
+    }
+    pthread_mutex_destroy(&in->lock);
+    pthread_cond_destroy(&in->filled);
+    pthread_cond_destroy(&in->drained);
+    return ok;
+}
+
+void edgeFormatInit(EdgeFormat *f, const char *filename){
+
+    memset(f, 0, sizeof(EdgeFormat));
+    f->mtx = strstr(filename, ".mtx") != NULL;
+    f->first_line = true;
+    strcpy(f->format, "coordinate");
+    strcpy(f->symmetry, "general");
+}
+
+int parseIds(const char *p, long long *vals, int max){ // Up to max unsigned integers from the start of a line
+
+    int count = 0;
+
+    while(count < max){
+
+        while(*p == ' ' || *p == '\t' || *p == '\r'){
+            p++;
+        }
+        if(*p < '0' || *p > '9'){
+            break;
+        }
+
+        long long val = 0;
+
+        while(*p >= '0' && *p <= '9'){
+            val = val * 10 + (*p - '0');
+            p++;
+        }
+        vals[count++] = val;
+    }
+    return count;
+}
+
+int edgeFormatLine(EdgeFormat *f, const char *line, long long *u, long long *v){
+
+    if(f->first_line && strncasecmp(line, "%%MatrixMarket", 14) == 0){ // %%MatrixMarket matrix <format> <field> <symmetry>
+        f->mtx = true;
+        sscanf(line + 14, "%*s %63s %*s %63s", f->format, f->symmetry);
+    }
+    f->first_line = false;
+
+    if(line[0] == '%' || line[0] == '#'){
+        return LINE_SKIP;
+    }
+
+    long long vals[3];
+    int count = parseIds(line, vals, (f->mtx && !f->sized) ? 3 : 2);
+
+    if(f->mtx && !f->sized){
+
+        if(count == 0 && line[strspn(line, " \t\r\n")] == '\0'){
+            return LINE_SKIP;
+        }
+        if(count != 3){
+            return LINE_BAD_SIZE;
+        }
+        f->rows = vals[0];
+        f->cols = vals[1];
+        f->nnz = vals[2];
+        f->sized = true;
+        return LINE_SIZE;
+    }
+    if(count != 2){
+        return LINE_SKIP;
+    }
+    *u = vals[0];
+    *v = vals[1];
+
+    if(f->mtx){
+
+        long long n = (f->rows > f->cols) ? f->rows : f->cols;
+
+        (*u)--;
+        (*v)--;
+        if(*u < 0 || *v < 0 || *u >= n || *v >= n){
+            return LINE_SKIP;
+        }
+    }
+    return LINE_EDGE;
+}
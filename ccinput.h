@@ -0,0 +1,67 @@
+#ifndef CCINPUT_H
+#define CCINPUT_H
+
+// Inputs are read through zlib, which passes uncompressed files through unchanged, so .mtx files, SNAP edge
+// lists and their .gz versions share one path, and a SuiteSparse .tar.gz is unpacked on the fly. A reader
+// thread inflates up to READ_BUFFERS chunks ahead of the parser, so decompression overlaps parsing.
+//
+// Lines are then classified by edgeFormatLine, so the backends, ccstream and the size probe agree on what a
+// MatrixMarket file (banner, 1-based entries after a size line) or a SNAP-style edge list (0-based, '#'
+// comments, as many vertices as the largest id needs) holds. A .mtx name or a banner selects MatrixMarket.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <zlib.h>
+
+#define READ_CHUNK (1 << 22)
+#define READ_BUFFERS 4
+#define TAR_BLOCK 512
+
+typedef struct Input{
+    gzFile gz;
+    long long remaining;    // bytes left in the selected tar member, -1 for a whole stream
+    char *buf[READ_BUFFERS];
+    size_t len[READ_BUFFERS];
+    int head;               // next chunk for the parser
+    int tail;               // next chunk for the reader
+    int ready;              // chunks filled and not yet released by the parser
+    bool done;              // reader reached the end of the input
+    bool stop;              // parser closed the input early
+    bool error;             // truncated or corrupt stream
+    char *cur;              // chunk being parsed, NULL before the first one
+    size_t pos;
+    long long bytes;        // uncompressed bytes handed to the parser
+    pthread_t reader;
+    pthread_mutex_t lock;
+    pthread_cond_t filled;
+    pthread_cond_t drained;
+}Input;
+
+bool inputOpen(Input *in, const char *filename);
+bool inputTarMember(Input *in, const char *filename); // Positions the stream at the matrix of a SuiteSparse archive, D/D.mtx
+bool inputNext(Input *in);                            // Releases the chunk just parsed and waits for the next one
+char *inputGets(Input *in, char *line, int size);     // fgets over the chunk stream, lines may span chunks
+bool inputClose(Input *in);                           // Returns false when the stream turned out truncated or corrupt
+
+typedef struct EdgeFormat{
+    bool mtx;
+    bool first_line;
+    bool sized;             // MatrixMarket size line read
+    char format[64];        // from the MatrixMarket banner
+    char symmetry[64];
+    long long rows;
+    long long cols;
+    long long nnz;
+}EdgeFormat;
+
+enum { LINE_SKIP, LINE_EDGE, LINE_SIZE, LINE_BAD_SIZE };
+
+void edgeFormatInit(EdgeFormat *f, const char *filename);
+
+// Returns LINE_EDGE with a 0-based pair in u and v, LINE_SIZE once the MatrixMarket size line is read
+// (LINE_BAD_SIZE when it does not parse) and LINE_SKIP for banners, comments, blank lines, negative ids and
+// MatrixMarket entries outside the matrix. Self loops are left to the caller.
+int edgeFormatLine(EdgeFormat *f, const char *line, long long *u, long long *v);
+
+#endif
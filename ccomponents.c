@@ -1,273 +1,210 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <string.h>
+#include <strings.h>
 #include <time.h>
-
- 
-typedef struct Graph{ //CSR Graph struct
-    int vertices;
-    long long num_edges;
-    int *edges;
-    long long *offsets;
-    int *labels;
-}Graph;
-
-Graph * createGraph(int vertices){ // Create empty graph
-    
-    Graph* g = malloc(sizeof(Graph));
-    
-    if(!g){
-        return NULL;
-    } 
-    g->vertices = vertices;
-    g->num_edges = 0;
-    g->edges = NULL;
-    g->offsets = calloc(vertices + 1, sizeof(long long));
-    g->labels = malloc(vertices * sizeof(int));
-    
-    for(int i = 0; i < vertices; i++){
-        g->labels[i] = i; 
-    }
-    return g;
-}
-
-void freeGraph(Graph* g){ // Free memory allocated for the graph
-    
-    if(!g){
-        return;
-    }
-
-    free(g->edges);
-    free(g->offsets);
-    free(g->labels);
-    free(g);
-}
-void saveBinGraph(Graph* g, const char* filename) { // Save graph to binary file the first time the program is run
-    
-    FILE* f = fopen(filename, "wb");
-    
-    if (!f){
-        return;
-    }
-    fwrite(&g->vertices, sizeof(int), 1, f);
-    fwrite(&g->num_edges, sizeof(long long), 1, f);
-    fwrite(g->offsets, sizeof(long long), g->vertices + 1, f);
-    fwrite(g->edges, sizeof(int), g->num_edges, f);
-    fclose(f);
-    printf("Saved binary file: %s\n", filename);
-}
-
-Graph* loadBinGraph(const char* filename) { // Load graph from binary file after having been saved
-    FILE* f = fopen(filename, "rb");
-    
-    if (!f) {
-        return NULL;
-    }
-
-    int n;
-    long long num_edges;
-    
-    if (fread(&n, sizeof(int), 1, f) != 1) {
-        fclose(f); 
-        return NULL;
-    }
-    
-    if (fread(&num_edges, sizeof(long long), 1, f) != 1) { 
-        fclose(f);
-        return NULL; 
-    }
-
-    Graph* g = createGraph(n);
-
-    g->num_edges = num_edges;
-    g->edges = malloc(num_edges * sizeof(int));
-    
-    fread(g->offsets, sizeof(long long), n + 1, f);
-    fread(g->edges, sizeof(int), num_edges, f);
-    
-    fclose(f);
-    return g;
-}
-
-Graph *readMTX(const char* filename){ // Read graph from .mtx file
-    FILE* f = fopen(filename, "r");
-
-    if(!f){
-        return NULL;
-    }
-
-    char line[1024]; // to skip comments in mtx files
-    
-    while(fgets(line, sizeof(line), f)){
-        
-        if(line[0] != '%'){
-            break;
-        }
-    }
-
-    int rows , cols;
-    long long nnz;
-    
-    if(sscanf(line, "%d %d %lld", &rows, &cols, &nnz) != 3){
-        fclose(f);
-        return NULL;
-    }
-    
-    int n = (rows > cols) ? rows : cols;
-    
-    Graph *g = createGraph(n);
-    long data_start = ftell(f);
-    int *temp = calloc(n, sizeof(int));
-    
-    if(!temp){
-        fclose(f);
-        return NULL;
-    }
-     
-    long long count = 0;
-    
-    while(count < nnz && fgets(line, sizeof(line), f)){
-        int u , v;
-        if(sscanf(line, "%d %d", &u, &v) == 2){
-            u--; v--; 
-            if (u >= n || v >= n){
-                continue;
-            }
-            if (u == v){
-                continue;
-            }
-            temp[u]++;
-            temp[v]++;            
-            count++;
-        }
-    }
-    
-    g->offsets[0] = 0;
-    
-    for(int i =1; i <= n; i++){
-        g->offsets[i] = g->offsets[i-1] + temp[i-1];
-    }
-    
-    g->num_edges = g->offsets[n];
-    g->edges = malloc(g->num_edges * sizeof(int));
-    
-    if(!g->edges){
-        printf("NOT ENOUGH MEMORY\n");
-        free(temp);
-        fclose(f);
-        return NULL;
-    } 
-    rewind(f);
-    fseek(f, data_start, SEEK_SET); 
-    
-    for(int i= 0; i <n; i++){
-        temp[i] = 0;
-    }
-
-    count = 0;
-
-    while(count < nnz && fgets(line, sizeof(line), f)){
-        
-        int u, v;
-        
-        if(sscanf(line, "%d %d", &u, &v) == 2){
-            u--;
-            v--; 
-            if (u >= n || v >= n){
-                continue;
-            } 
-            if (u == v) {
-                continue;
-            }
-            
-            int u1 = g->offsets[u] + temp[u]++; // position to insert v in u's adjacency list
-            g->edges[u1] = v;
-            
-            int v1 = g->offsets[v] + temp[v]++; // position to insert u in v's adjacency list
-            g->edges[v1] = u;
-            
-            count++;
-        }
-    }
-    free(temp);
-    fclose(f);
-    return g;
-}
-void ColoringAlgorithm(Graph* g){
-
-    int n = g->vertices;
-    int *labels = g->labels;
-    long long *offsets = g->offsets;
-    int *edges = g->edges;
-    
-    for(int i=0;i<n;i++){
+#include <sys/resource.h>
+#include <errno.h>
+#include <zlib.h>
+#include <pthread.h>
+#include "ccarena.h"
+#include "ccinput.h"
+#include "ccgraph.h"
+#include "ccparallel.h"
+#include "ccperf.h"
+#include "ccprefetch.h"
+
+int prefetch_option = PREFETCH_AUTO; // --prefetch: edges the label prefetch runs ahead, 0 is off
+int prefetch_distance = 0;           // what the current graph runs with
+
+int ColoringAlgorithm(Graph* g){ // Returns the number of sweeps until no label changed
+
+    vertex_t n = g->vertices;
+    vertex_t *labels = g->labels;
+    
+    for(vertex_t i=0;i<n;i++){
         labels[i] = i;
     }
     
+    prefetch_distance = resolvePrefetch(prefetch_option, n);
+
+    bool prefetch = prefetch_distance > 0;
     bool changed = true;
+    int iterations = 0;
     
     while(changed){
 
         changed = false;
+        iterations++;
+        TRACE(TraceIteration *it = traceIteration(); double it_start = traceTime());
 
-        for(int v=0;v<n;v++){
+        Lookahead ahead = {g->offsets, g->edges, g->labels, NULL, n, 1};
+        lookaheadStart(&ahead, 0, prefetch_distance);
+
+        for(vertex_t v=0;v<n;v++){
             
-            long long start = g->offsets[v];
-            long long end = g->offsets[v+1];
+            edge_t start = g->offsets[v];
+            edge_t end = g->offsets[v+1];
 
-            for(long long k=start; k<end; k++){
+            for(edge_t k=start; k<end; k++){
 
-                int u = g->edges[k];
+                vertex_t u = g->edges[k];
 
+                if(prefetch){
+                    lookaheadStep(&ahead);
+                }
                 if(g->labels[v] > g->labels[u]){
                     g->labels[v] = g->labels[u];
                     changed = true;
+                    TRACE(it->changed++);
                 }
             }
         }
+        TRACE(it->time = traceTime() - it_start; it->busy[0] = it->time; it->edges = g->offsets[n]);
+        if(perf.per_iteration){
+            perfSample("iteration", iterations, (double)g->offsets[g->vertices]);
+        }
     }
+    return iterations;
 }
 
-    
-
 int main(int argc, char* argv[]){
     
     if(argc < 2){
-        printf("opening: %s <matrix_file.mtx>\n", argv[0]);
+        printf("opening: %s <matrix_file.mtx[.gz] | edge_list.txt[.gz] | archive.tar.gz> [--labels] [--csv] [--perf] [--perf-iter]\n"
+               "         [--prefetch auto|<distance>] [--pipeline]\n", argv[0]);
         return 1;
     }
+    selectBuild(argv);
+
+    bool save_labels = false;
+    bool save_csv = false;
+    bool use_perf = false;
+    bool use_pipeline = false;
+
+    for(int i = 2; i < argc; i++){
+        if(strcmp(argv[i], "--labels") == 0){
+            save_labels = true;
+        }
+        else if(strcmp(argv[i], "--csv") == 0){
+            save_labels = true;
+            save_csv = true;
+        }
+        else if(strcmp(argv[i], "--perf") == 0){
+            use_perf = true;
+        }
+        else if(strcmp(argv[i], "--perf-iter") == 0){
+            use_perf = true;
+            perf.per_iteration = true;
+        }
+        else if(strcmp(argv[i], "--prefetch") == 0 && i + 1 < argc){
+            i++;
+            prefetch_option = (strcmp(argv[i], "auto") == 0) ? PREFETCH_AUTO : atoi(argv[i]);
+        }
+        else if(strcmp(argv[i], "--pipeline") == 0){
+            use_pipeline = true;
+        }
+    }
+
+    if(use_perf){
+        perfOpen();
+    }
     
     char bin_name[256];
-    snprintf(bin_name, sizeof(bin_name), "%s.bin", argv[1]);
+    snprintf(bin_name, sizeof(bin_name), "%s" BIN_SUFFIX, argv[1]);
+    double wall_start = wallTime();
+    TRACE(double phase_start = traceTime());
     Graph* g = loadBinGraph(bin_name);
+    TRACE(if(g) trace.phase[PHASE_LOAD_CACHE] = traceTime() - phase_start);
+    Pipeline pipe_state;
+    CacheWriter writer = {0};
+    bool parsed = !g;
+    bool seeded = false; // labels already final, the sweeps are skipped
     
     if(!g){
+        pipeline = use_pipeline ? &pipe_state : NULL;
         g = readMTX(argv[1]);
         
+        if(!g && wider_build){
+            execBuild(argv, wider_build);
+        }
         if(!g){
             printf("Failed to load graph from %s\n", argv[1]);
             return 1;
         }
-        saveBinGraph(g, bin_name);
+        if(use_pipeline){
+            seeded = pipelineSeed(pipeline, g);
+            cacheWriteStart(&writer, g, bin_name);
+        }
+        else{
+            TRACE(phase_start = traceTime());
+            saveBinGraph(g, bin_name);
+            TRACE(trace.phase[PHASE_CACHE_WRITE] = traceTime() - phase_start);
+        }
     }
     else{
         printf("Loaded binary graph: %s\n", bin_name);
     }
-    
-    clock_t start_time = clock(); // Start Timer
-    ColoringAlgorithm(g);
-    clock_t end_time = clock(); // End Timer
-    double time_taken = ((double)(end_time - start_time)) / CLOCKS_PER_SEC;
-
-    int num_components = 0;
-    for(int i=0; i<g->vertices; i++){
-        if(g->labels[i] == i){
-            num_components++;
+    double load_time = wallTime() - wall_start;
+    
+    perfSample("load", -1, 0);
+    struct timespec start, end; // wall time, comparable with the parallel backends
+    clock_gettime(CLOCK_MONOTONIC, &start); // Start Timer
+    int iterations = seeded ? 0 : ColoringAlgorithm(g);
+    clock_gettime(CLOCK_MONOTONIC, &end); // End Timer
+    double time_taken = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    perfSample("compute", -1, (double)iterations * g->offsets[g->vertices]);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    Components* c = computeComponents(g);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    perfSample("stats", -1, 0);
+    double post_time = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    vertex_t largest = 0;
+    for(vertex_t i = 0; i < c->count; i++){
+        if(c->sizes[i] > largest){
+            largest = c->sizes[i];
         }
     }
-    printf("Total Vertices: %d\n", g->vertices);
-    printf("Number of Connected Components: %d\n", num_components);
-    printf("time taken: %f seconds\n", time_taken);
+    cacheWriteWait(&writer);
+    TRACE(if(use_pipeline && parsed) trace.phase[PHASE_CACHE_WRITE] = writer.seconds);
+    double wall_time = wallTime() - wall_start;
+
+    printf("Total Vertices: %lld\n", (long long)g->vertices);
+    printf("Total Edges: %lld\n", (long long)g->offsets[g->vertices]);
+    printf("Graph arena: %.1f MB on %s pages\n", g->arena.used / 1048576.0, g->arena.backing);
+    printf("Threads: 1\n");
+    if(prefetch_distance > 0){
+        printf("Label prefetch: %d edges ahead\n", prefetch_distance);
+    }
+    else{
+        printf("Label prefetch: off\n");
+    }
+    printf("Number of Connected Components: %lld\n", (long long)c->count);
+    printf("Largest Component: %lld vertices\n", (long long)largest);
+    printf("Iterations: %d\n", iterations);
+    printf("Time taken: %f seconds\n", time_taken);
+    printf("Component statistics time: %f seconds\n", post_time);
+    if(use_pipeline){
+        pipelineReport(&pipe_state, &writer, parsed);
+    }
+    printf("End to end: %f seconds (load %f, compute %f, stats %f)\n", wall_time, load_time, time_taken, post_time);
+
+    if(save_labels){
+        saveComponents(g, c, argv[1], save_csv);
+    }
+    TRACE(trace.phase[PHASE_COMPUTE] = time_taken);
+    TRACE(trace.phase[PHASE_STATS] = post_time);
+    TRACE(traceWrite(argv[1], "seq", (long long)g->vertices, (long long)g->offsets[g->vertices]));
+    perfClose();
+    freeComponents(c);
     freeGraph(g);
     return 0;
 }
\ No newline at end of file
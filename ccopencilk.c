@@ -1,276 +1,566 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <string.h>
+#include <strings.h>
 #include <cilk/cilk.h>
+#include <cilk/cilk_api.h>
 #include <time.h>
+#include <sys/resource.h>
+#include <errno.h>
+#include <zlib.h>
+#include <pthread.h>
+#include "ccarena.h"
+#include "ccinput.h"
+#include "ccgraph.h"
+#include "ccparallel.h"
+#include "ccperf.h"
+#include "ccprefetch.h"
 
+#define SWEEP_BLOCK 512 // vertices per cilk_for iteration of a sweep
 
-typedef struct Graph{
-    int vertices;
-    long long num_edges;
-    int *edges;
-    long long *offsets;
-    int *labels;
-}Graph;
+int prefetch_option = PREFETCH_AUTO; // --prefetch: edges the label prefetch runs ahead, 0 is off
+int prefetch_distance = 0;           // what the current graph runs with
 
-Graph * createGraph(int vertices){
-    
-    Graph* g = malloc(sizeof(Graph));
-    if(!g){
-        return NULL;
-    } 
-    g->vertices = vertices;
-    g->num_edges = 0;
-    g->edges = NULL;
-    g->offsets = calloc(vertices + 1, sizeof(long long));
-    g->labels = malloc(vertices * sizeof(int));
-
-    cilk_for(int i = 0; i < vertices; i++){ // Cilk_for for parallel initialization
-        g->labels[i] = i; 
-    }
-    return g;
-}
+int ColoringAlgorithm(Graph* g){ // Returns the number of sweeps until no label changed
 
-void freeGraph(Graph* g){
-    if(!g){
-        return;
+    vertex_t n = g->vertices;
+    vertex_t * labels = g->labels;
+    edge_t * offsets = g->offsets;
+    vertex_t * edges = g->edges;
+
+    prefetch_distance = resolvePrefetch(prefetch_option, n);
+
+    bool prefetch = prefetch_distance > 0;
+
+    cilk_for(vertex_t i=0;i<n;i++){
+        labels[i] = i;
     }
 
-    free(g->edges);
-    free(g->offsets);
-    free(g->labels);
-    free(g);
-}
-void saveBinGraph(Graph* g, const char* filename) {
-    
-    FILE* f = fopen(filename, "wb");
-    
-    if (!f){
-        return;    
-    } 
-
-    fwrite(&g->vertices, sizeof(int), 1, f);
-    fwrite(&g->num_edges, sizeof(long long), 1, f);
-    fwrite(g->offsets, sizeof(long long), g->vertices + 1, f);
-    fwrite(g->edges, sizeof(int), g->num_edges, f);
-    fclose(f);
-    printf("Saved binary file: %s\n", filename);
-}
+    bool changed = true;
+    int iterations = 0;
 
-Graph* loadBinGraph(const char* filename) {
-    FILE* f = fopen(filename, "rb");
-    if (!f){
-        return NULL;
-    } 
-    
-    int n;
-    long long num_edges;
-    
-    if (fread(&n, sizeof(int), 1, f) != 1) {
-        fclose(f);
-        return NULL;
+    while(changed){
+
+        changed = false;
+        iterations++;
+        TRACE(TraceIteration *it = traceIteration(); double it_start = traceTime());
+
+        cilk_for(vertex_t block=0;block<n;block+=SWEEP_BLOCK){ // one worker runs a whole block, so its busy time can be attributed
+            
+            vertex_t block_end = (n - block < SWEEP_BLOCK) ? n : block + SWEEP_BLOCK;
+            TRACE(double busy_start = traceTime(); long long local_changed = 0);
+            Lookahead ahead = {g->offsets, g->edges, g->labels, NULL, block_end, 1};
+            lookaheadStart(&ahead, block, prefetch_distance);
+
+            for(vertex_t v=block;v<block_end;v++){
+
+                edge_t start = offsets[v];
+                edge_t end = offsets[v+1];
+
+                for(edge_t k = start; k< end; k++){
+
+                    vertex_t u = edges[k];
+                    
+                    if(prefetch){
+                        lookaheadStep(&ahead);
+                    }
+                    if(g->labels[v] > g->labels[u]){
+                        g->labels[v] = g->labels[u];
+                        if(!changed){
+                            changed = true;
+                        }
+                        TRACE(local_changed++);
+                    }
+                }
+            }
+            TRACE(it->busy[__cilkrts_get_worker_number()] += traceTime() - busy_start);
+            TRACE(__atomic_fetch_add(&it->changed, local_changed, __ATOMIC_RELAXED));
+        }
+        TRACE(it->time = traceTime() - it_start; it->edges = offsets[n]);
+        if(perf.per_iteration){
+            perfSample("iteration", iterations, (double)g->offsets[g->vertices]);
         }
-    
-    if (fread(&num_edges, sizeof(long long), 1, f) != 1) { 
-        fclose(f);
-        return NULL; 
     }
-
-    Graph* g = createGraph(n);
-    
-    g->num_edges = num_edges;
-    g->edges = malloc(num_edges * sizeof(int));
-    
-    fread(g->offsets, sizeof(long long), n + 1, f);
-    fread(g->edges, sizeof(int), num_edges, f);
-    
-    fclose(f);
-    return g;
+    return iterations;
 }
 
-Graph *readMTX(const char* filename){
-    FILE* f = fopen(filename, "r");
+// Giant component peel (--engine peel). A direction-optimizing BFS from the highest-degree vertex labels
+// the component holding it in a few level-synchronous steps, then label propagation runs only on the
+// vertices the BFS did not reach, none of which touches the giant. Top-down steps expand a frontier queue;
+// when the frontier's edges exceed the unexplored edges / PEEL_ALPHA a step goes bottom-up instead, every
+// unvisited vertex looking for a parent in a frontier byte map, and it returns to top-down once the
+// frontier shrinks below n / PEEL_BETA (Beamer's switching rule).
+#define PEEL_ALPHA 14
+#define PEEL_BETA 24
+#define PEEL_STAGE 1024 // per-block staging for the next frontier queue
+#define PEEL_BLOCK 64   // frontier vertices per cilk_for iteration of a top-down step
+
+typedef struct PeelStats{
+    vertex_t root;
+    vertex_t reached;       // vertices in the peeled component
+    int levels;
+    int bottom_up;          // levels run bottom-up
+    long long scanned;      // edges looked at by the BFS
+    long long rest_edges;   // edges swept by each propagation round afterwards
+}PeelStats;
 
-    if(!f){
-        return NULL;
+PeelStats peel = {0};
+
+vertex_t collectVertices(const unsigned char *mark, unsigned char value, vertex_t n, vertex_t *out){ // Vertices with mark[v] == value, in increasing order
+
+    int blocks = __cilkrts_get_nworkers();
+    vertex_t *start = calloc(blocks + 1, sizeof(vertex_t));
+
+    cilk_for(int b = 0; b < blocks; b++){
+        vertex_t count = 0;
+
+        for(vertex_t v = (long long)n * b / blocks; v < (long long)n * (b + 1) / blocks; v++){
+            count += (mark[v] == value);
+        }
+        start[b + 1] = count;
     }
-    
-    char line[1024]; // to skip comments in mtx files
-    
-    while(fgets(line, sizeof(line), f)){
-        if(line[0] != '%'){
-            break;
+    for(int b = 0; b < blocks; b++){
+        start[b + 1] += start[b];
+    }
+
+    cilk_for(int b = 0; b < blocks; b++){
+        vertex_t pos = start[b];
+
+        for(vertex_t v = (long long)n * b / blocks; v < (long long)n * (b + 1) / blocks; v++){
+            if(mark[v] == value){
+                out[pos++] = v;
+            }
         }
     }
+    vertex_t total = start[blocks];
+    free(start);
+    return total;
+}
 
-    int rows , cols;
-    long long nnz;
-    
-    if(sscanf(line, "%d %d %lld", &rows, &cols, &nnz) != 3){
-        fclose(f);
-        return NULL;
+int PeelAlgorithm(Graph* g){ // Returns the propagation rounds needed after the peel
+
+    vertex_t n = g->vertices;
+    vertex_t * labels = g->labels;
+    edge_t * offsets = g->offsets;
+    vertex_t * edges = g->edges;
+
+    prefetch_distance = resolvePrefetch(prefetch_option, n);
+
+    bool prefetch = prefetch_distance > 0;
+
+    memset(&peel, 0, sizeof(peel));
+
+    if(n == 0){
+        return 0;
     }
-    
-    int n = (rows > cols) ? rows : cols;
-    
-    Graph *g = createGraph(n);
-    long data_start = ftell(f);
-    int *temp = calloc(n, sizeof(int));
-    
-    if(!temp){
-        fclose(f);
-        return NULL;
+
+    int blocks = __cilkrts_get_nworkers();
+    vertex_t *best = malloc(blocks * sizeof(vertex_t)); // per-range root candidate, later the per-range minimum of the peeled component
+
+    if(!best){
+        printf("NOT ENOUGH MEMORY\n");
+        exit(1);
     }
-     
-    long long count = 0;
-    
-    while(count < nnz && fgets(line, sizeof(line), f)){
-        
-        int u , v;
-        
-        if(sscanf(line, "%d %d", &u, &v) == 2){
-            u--; v--; 
-            if (u >= n || v >= n){
-                continue;
-            }
-            if (u == v){
-                continue;
+
+    cilk_for(int b = 0; b < blocks; b++){
+        vertex_t lo = (long long)n * b / blocks;
+        vertex_t hi = (long long)n * (b + 1) / blocks;
+
+        best[b] = lo;
+        for(vertex_t v = lo; v < hi; v++){
+            if(offsets[v + 1] - offsets[v] > offsets[best[b] + 1] - offsets[best[b]]){
+                best[b] = v;
             }
-            temp[u]++;
-            temp[v]++;            
-            count++;
         }
     }
-    
-    g->offsets[0] = 0;
-    
-    for(int i =1; i <= n; i++){
-        g->offsets[i] = g->offsets[i-1] + temp[i-1];
+    vertex_t root = 0;
+
+    for(int b = 0; b < blocks; b++){ // ranges are in order, so ties keep the lowest id
+        if(offsets[best[b] + 1] - offsets[best[b]] > offsets[root + 1] - offsets[root]){
+            root = best[b];
+        }
     }
-    
-    g->num_edges = g->offsets[n];
-    g->edges = malloc(g->num_edges * sizeof(int));
-    
-    if(!g->edges){
+
+    unsigned char *visited = calloc(n, 1);
+    unsigned char *front_map = calloc(n, 1);
+    unsigned char *next_map = calloc(n, 1);
+    vertex_t *queue = malloc(n * sizeof(vertex_t));
+    vertex_t *next = malloc(n * sizeof(vertex_t));
+
+    if(!visited || !front_map || !next_map || !queue || !next){
         printf("NOT ENOUGH MEMORY\n");
-        free(temp);
-        fclose(f);
-        return NULL;
-    }
-    rewind(f);
-    fseek(f, data_start, SEEK_SET); 
-    
-    for(int i= 0; i <n; i++){
-        temp[i] = 0;
+        exit(1);
     }
 
-    count = 0;
+    visited[root] = 1;
+    queue[0] = root;
 
-    while(count < nnz && fgets(line, sizeof(line), f)){
-        
-        int u, v;
-        
-        if(sscanf(line, "%d %d", &u, &v) == 2){
-            u--;
-            v--; 
-            if (u >= n || v >= n){
-                continue;
-            } 
-            if (u == v) {
-                continue;
+    vertex_t front_size = 1;
+    long long front_edges = offsets[root + 1] - offsets[root];
+    long long unexplored = (long long)offsets[n] - front_edges;
+    long long scanned = 0;
+    vertex_t reached = 1;
+    bool bottom_up = false; // which frontier is live: front_map when true, queue otherwise
+
+    while(front_size > 0){
+
+        peel.levels++;
+
+        if(!bottom_up && front_edges > unexplored / PEEL_ALPHA){
+            cilk_for(vertex_t i = 0; i < front_size; i++){
+                front_map[queue[i]] = 1;
             }
-            int u1 = g->offsets[u] + temp[u]++;
-            g->edges[u1] = v;
-            
-            int v1 = g->offsets[v] + temp[v]++;
-            g->edges[v1] = u;
-            
-            count++;
+            bottom_up = true;
+        }
+        else if(bottom_up && front_size < n / PEEL_BETA){
+            collectVertices(front_map, 1, n, queue);
+            memset(front_map, 0, n);
+            bottom_up = false;
+        }
+
+        vertex_t next_size = 0;
+        long long next_edges = 0;
+
+        if(bottom_up){
+
+            peel.bottom_up++;
+
+            cilk_for(vertex_t block = 0; block < n; block += SWEEP_BLOCK){
+
+                vertex_t block_end = (n - block < SWEEP_BLOCK) ? n : block + SWEEP_BLOCK;
+                vertex_t found = 0;
+                long long found_edges = 0;
+                long long looked = 0;
+
+                for(vertex_t v = block; v < block_end; v++){
+
+                    if(visited[v]){
+                        continue;
+                    }
+                    for(edge_t k = offsets[v]; k < offsets[v + 1]; k++){
+                        looked++;
+                        if(front_map[edges[k]]){
+                            visited[v] = 1;
+                            next_map[v] = 1;
+                            found++;
+                            found_edges += offsets[v + 1] - offsets[v];
+                            break;
+                        }
+                    }
+                }
+                __atomic_fetch_add(&next_size, found, __ATOMIC_RELAXED);
+                __atomic_fetch_add(&next_edges, found_edges, __ATOMIC_RELAXED);
+                __atomic_fetch_add(&scanned, looked, __ATOMIC_RELAXED);
+            }
+            unsigned char *swap = front_map;
+            front_map = next_map;
+            next_map = swap;
+            memset(next_map, 0, n);
+        }
+        else{
+            cilk_for(vertex_t block = 0; block < front_size; block += PEEL_BLOCK){
+
+                vertex_t block_end = (front_size - block < PEEL_BLOCK) ? front_size : block + PEEL_BLOCK;
+                vertex_t stage[PEEL_STAGE];
+                int staged = 0;
+                long long found_edges = 0;
+                long long looked = 0;
+
+                for(vertex_t i = block; i < block_end; i++){
+
+                    vertex_t v = queue[i];
+
+                    for(edge_t k = offsets[v]; k < offsets[v + 1]; k++){
+
+                        vertex_t u = edges[k];
+                        looked++;
+
+                        if(!visited[u] && __atomic_exchange_n(&visited[u], 1, __ATOMIC_RELAXED) == 0){
+                            stage[staged++] = u;
+                            found_edges += offsets[u + 1] - offsets[u];
+
+                            if(staged == PEEL_STAGE){
+                                vertex_t pos = __atomic_fetch_add(&next_size, staged, __ATOMIC_RELAXED);
+                                memcpy(next + pos, stage, staged * sizeof(vertex_t));
+                                staged = 0;
+                            }
+                        }
+                    }
+                }
+                vertex_t pos = __atomic_fetch_add(&next_size, staged, __ATOMIC_RELAXED);
+                memcpy(next + pos, stage, staged * sizeof(vertex_t));
+                __atomic_fetch_add(&next_edges, found_edges, __ATOMIC_RELAXED);
+                __atomic_fetch_add(&scanned, looked, __ATOMIC_RELAXED);
+            }
+            vertex_t *swap = queue;
+            queue = next;
+            next = swap;
         }
+        front_size = next_size;
+        front_edges = next_edges;
+        unexplored -= next_edges;
+        reached += next_size;
     }
-    free(temp);
-    fclose(f);
-    return g;
-}
-void ColoringAlgorithm(Graph* g){
 
-    int n = g->vertices;
-    int * labels = g->labels;
-    long long * offsets = g->offsets;
-    int * edges = g->edges;
+    // The peeled component takes its minimum id, like propagation would give it
+    cilk_for(int b = 0; b < blocks; b++){
+        vertex_t v = (long long)n * b / blocks;
+        vertex_t hi = (long long)n * (b + 1) / blocks;
 
-    
-    cilk_for(int i=0;i<n;i++){
-        labels[i] = i;
+        while(v < hi && !visited[v]){
+            v++;
+        }
+        best[b] = (v < hi) ? v : n;
     }
+    vertex_t min_id = n;
 
-    bool changed = true;
+    for(int b = 0; b < blocks && min_id == n; b++){
+        min_id = best[b];
+    }
+    free(best);
+
+    cilk_for(vertex_t v = 0; v < n; v++){
+        labels[v] = visited[v] ? min_id : v;
+    }
+
+    vertex_t rest = collectVertices(visited, 0, n, queue);
+    long long rest_edges = 0;
+
+    cilk_for(vertex_t block = 0; block < rest; block += SWEEP_BLOCK){
+        vertex_t block_end = (rest - block < SWEEP_BLOCK) ? rest : block + SWEEP_BLOCK;
+        long long sum = 0;
+
+        for(vertex_t i = block; i < block_end; i++){
+            sum += offsets[queue[i] + 1] - offsets[queue[i]];
+        }
+        __atomic_fetch_add(&rest_edges, sum, __ATOMIC_RELAXED);
+    }
+    peel.root = root;
+    peel.reached = reached;
+    peel.scanned = scanned;
+    peel.rest_edges = rest_edges;
+
+    bool changed = rest > 0;
+    int iterations = 0;
 
     while(changed){
 
         changed = false;
+        iterations++;
+        TRACE(TraceIteration *it = traceIteration(); double it_start = traceTime());
 
-        cilk_for(int v=0;v<n;v++){
-            
-            long long start = offsets[v];
-            long long end = offsets[v+1];
+        cilk_for(vertex_t block = 0; block < rest; block += SWEEP_BLOCK){
+
+            vertex_t block_end = (rest - block < SWEEP_BLOCK) ? rest : block + SWEEP_BLOCK;
+            TRACE(double busy_start = traceTime(); long long local_changed = 0);
+            Lookahead ahead = {g->offsets, g->edges, g->labels, queue, block_end, 1};
+            lookaheadStart(&ahead, block, prefetch_distance);
+
+            for(vertex_t i = block; i < block_end; i++){
+
+                vertex_t v = queue[i];
+
+                for(edge_t k = offsets[v]; k < offsets[v + 1]; k++){
 
-            for(long long k = start; k< end; k++){
+                    vertex_t u = edges[k];
 
-                int u = edges[k];
-                
-                if(g->labels[v] > g->labels[u]){
-                    g->labels[v] = g->labels[u];
-                    if(!changed){
-                        changed = true;
+                    if(prefetch){
+                        lookaheadStep(&ahead);
+                    }
+                    if(labels[v] > labels[u]){
+                        labels[v] = labels[u];
+                        if(!changed){
+                            changed = true;
+                        }
+                        TRACE(local_changed++);
                     }
                 }
             }
+            TRACE(it->busy[__cilkrts_get_worker_number()] += traceTime() - busy_start);
+            TRACE(__atomic_fetch_add(&it->changed, local_changed, __ATOMIC_RELAXED));
+        }
+        TRACE(it->time = traceTime() - it_start; it->edges = rest_edges);
+        if(perf.per_iteration){
+            perfSample("iteration", iterations, (double)rest_edges);
         }
     }
+
+    free(visited);
+    free(front_map);
+    free(next_map);
+    free(queue);
+    free(next);
+    return iterations;
 }
 
-    
+void cilkParallel(int pieces, void (*piece)(void *ctx, int i), void *ctx){ // parallel.run for the shared loading code
+
+    cilk_for(int i = 0; i < pieces; i++){
+        piece(ctx, i);
+    }
+}
 
 int main(int argc, char* argv[]){
     if(argc < 2){
-        printf("opening: %s <matrix_file.mtx>\n", argv[0]);
+        printf("opening: %s <matrix_file.mtx[.gz] | edge_list.txt[.gz] | archive.tar.gz> [--labels] [--csv] [--perf] [--perf-iter] [--engine lp|peel]\n"
+               "         [--prefetch auto|<distance>] [--pipeline]\n", argv[0]);
         return 1;
     }
+    selectBuild(argv);
+
+    bool save_labels = false;
+    bool save_csv = false;
+    bool use_perf = false;
+    bool use_peel = false;
+    bool use_pipeline = false;
+
+    for(int i = 2; i < argc; i++){
+        if(strcmp(argv[i], "--labels") == 0){
+            save_labels = true;
+        }
+        else if(strcmp(argv[i], "--csv") == 0){
+            save_labels = true;
+            save_csv = true;
+        }
+        else if(strcmp(argv[i], "--perf") == 0){
+            use_perf = true;
+        }
+        else if(strcmp(argv[i], "--perf-iter") == 0){
+            use_perf = true;
+            perf.per_iteration = true;
+        }
+        else if(strcmp(argv[i], "--engine") == 0 && i + 1 < argc){
+            i++;
+            if(strcmp(argv[i], "peel") == 0){
+                use_peel = true;
+            }
+            else if(strcmp(argv[i], "lp") != 0){
+                printf("Unknown engine %s (lp, peel)\n", argv[i]);
+                return 1;
+            }
+        }
+        else if(strcmp(argv[i], "--prefetch") == 0 && i + 1 < argc){
+            i++;
+            prefetch_option = (strcmp(argv[i], "auto") == 0) ? PREFETCH_AUTO : atoi(argv[i]);
+        }
+        else if(strcmp(argv[i], "--pipeline") == 0){
+            use_pipeline = true;
+        }
+    }
+
+    parallel.threads = __cilkrts_get_nworkers();
+    parallel.run = cilkParallel;
+
+    if(use_perf){
+        cilk_for(int i = 0; i < __cilkrts_get_nworkers(); i++){ // start the workers so they get counters
+        }
+        perfOpen();
+    }
     char bin_name[256];
-    snprintf(bin_name, sizeof(bin_name), "%s.bin", argv[1]);
+    snprintf(bin_name, sizeof(bin_name), "%s" BIN_SUFFIX, argv[1]);
+    double wall_start = wallTime();
+    TRACE(double phase_start = traceTime());
     Graph* g = loadBinGraph(bin_name);
+    TRACE(if(g) trace.phase[PHASE_LOAD_CACHE] = traceTime() - phase_start);
+    Pipeline pipe_state;
+    CacheWriter writer = {0};
+    bool parsed = !g;
+    bool seeded = false; // labels already final, the sweeps are skipped
     
     if(!g){
+        pipeline = use_pipeline ? &pipe_state : NULL;
         g = readMTX(argv[1]);
         
+        if(!g && wider_build){
+            execBuild(argv, wider_build);
+        }
         if(!g){
             printf("Failed to load graph from %s\n", argv[1]);
             return 1;
         }
-        saveBinGraph(g, bin_name);
+        if(use_pipeline){
+            seeded = pipelineSeed(pipeline, g);
+            cacheWriteStart(&writer, g, bin_name);
+        }
+        else{
+            TRACE(phase_start = traceTime());
+            saveBinGraph(g, bin_name);
+            TRACE(trace.phase[PHASE_CACHE_WRITE] = traceTime() - phase_start);
+        }
     }
     else{
         printf("Loaded binary graph: %s\n", bin_name);
     }  
+    double load_time = wallTime() - wall_start;
     
+    perfSample("load", -1, 0);
+    TRACE(trace.threads = __cilkrts_get_nworkers());
     struct timespec start, end;
 
     clock_gettime(CLOCK_MONOTONIC, &start); // Start Timer
-    ColoringAlgorithm(g);
+    int iterations = seeded ? 0 : use_peel ? PeelAlgorithm(g) : ColoringAlgorithm(g);
     clock_gettime(CLOCK_MONOTONIC, &end); // End Timer
     
     double time_taken = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    double work = use_peel ? peel.scanned + (double)iterations * peel.rest_edges : (double)iterations * g->offsets[g->vertices];
+
+    perfSample("compute", -1, work);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    Components* c = computeComponents(g);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    perfSample("stats", -1, 0);
+    double post_time = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
 
-    int num_components = 0;
-    for(int i=0; i<g->vertices; i++){
-        if(g->labels[i] == i){
-            num_components++;
+    vertex_t largest = 0;
+    for(vertex_t i = 0; i < c->count; i++){
+        if(c->sizes[i] > largest){
+            largest = c->sizes[i];
         }
     }
-    printf("Total Vertices: %d\n", g->vertices);
-    printf("Number of Connected Components: %d\n", num_components);
+    cacheWriteWait(&writer);
+    TRACE(if(use_pipeline && parsed) trace.phase[PHASE_CACHE_WRITE] = writer.seconds);
+    double wall_time = wallTime() - wall_start;
+
+    printf("Total Vertices: %lld\n", (long long)g->vertices);
+    printf("Total Edges: %lld\n", (long long)g->offsets[g->vertices]);
+    printf("Graph arena: %.1f MB on %s pages\n", g->arena.used / 1048576.0, g->arena.backing);
+    printf("Threads: %d\n", __cilkrts_get_nworkers());
+    if(prefetch_distance > 0){
+        printf("Label prefetch: %d edges ahead\n", prefetch_distance);
+    }
+    else{
+        printf("Label prefetch: off\n");
+    }
+    printf("Engine: %s\n", seeded ? "pipeline" : use_peel ? "peel" : "lp");
+    printf("Number of Connected Components: %lld\n", (long long)c->count);
+    printf("Largest Component: %lld vertices\n", (long long)largest);
+    if(use_peel){
+        printf("Peel: %lld vertices (%.1f%%) from root %lld in %d BFS levels (%d bottom-up), %lld edges left for propagation\n",
+               (long long)peel.reached, g->vertices ? 100.0 * peel.reached / g->vertices : 0.0, (long long)peel.root,
+               peel.levels, peel.bottom_up, peel.rest_edges);
+    }
+    printf("Iterations: %d\n", iterations);
     printf("Time taken: %f seconds\n", time_taken);
+    printf("Component statistics time: %f seconds\n", post_time);
+    if(use_pipeline){
+        pipelineReport(&pipe_state, &writer, parsed);
+    }
+    printf("End to end: %f seconds (load %f, compute %f, stats %f)\n", wall_time, load_time, time_taken, post_time);
+
+    if(save_labels){
+        saveComponents(g, c, argv[1], save_csv);
+    }
+    TRACE(trace.phase[PHASE_COMPUTE] = time_taken);
+    TRACE(trace.phase[PHASE_STATS] = post_time);
+    TRACE(traceWrite(argv[1], "cilk", (long long)g->vertices, (long long)g->offsets[g->vertices]));
+    perfClose();
+    freeComponents(c);
     freeGraph(g);
     return 0;
 }
\ No newline at end of file
@@ -1,276 +1,640 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <sys/resource.h>
+#include <errno.h>
+#include <dirent.h>
+#include <zlib.h>
+#include <pthread.h>
+#include <malloc.h>
 #include <omp.h>
+#include "libcc.h"
+#include "ccarena.h"
+#include "ccinput.h"
+#include "ccgraph.h"
+#include "ccparallel.h"
+#include "ccauto.h"
+#include "ccperf.h"
 
+void onIteration(const cc_iteration *it, void *user){ // libcc progress hook: trace records and per-iteration counters
 
-typedef struct Graph{
-    int vertices;
-    long long num_edges;
-    int *edges;
-    long long *offsets;
-    int *labels;
-}Graph;
+    (void)user;
+    TRACE(TraceIteration *t = traceIteration(); t->time = it->seconds; t->changed = it->changed; t->edges = it->edges);
+    TRACE(for(int i = 0; i < it->threads && i < trace.threads; i++) t->busy[i] = it->busy[i]);
 
-Graph * createGraph(int vertices){
-
-    Graph* g = malloc(sizeof(Graph));
-    
-    if(!g){
-        return NULL;
-    } 
-    g->vertices = vertices;
-    g->num_edges = 0;
-    g->edges = NULL;
-    g->offsets = calloc(vertices + 1, sizeof(long long));
-    g->labels = malloc(vertices * sizeof(int));
-    
-    #pragma omp parallel for // Initialize labels in parallel
-    for(int i = 0; i < vertices; i++){
-        g->labels[i] = i; 
+    if(perf.per_iteration){
+        perfSample("iteration", it->iteration, (double)it->edges);
     }
-    return g;
 }
 
-void freeGraph(Graph* g){
-    
-    if(!g){
-        return;
-    }
+// Component extraction (--extract largest | top:K | min:S). The selected components become a graph of
+// their own, written straight into the binary cache format as <matrix_file>.<selection>.bin, which any
+// backend then loads as <matrix_file>.<selection>. Kept vertices are renumbered in their original order,
+// so adjacency lists stay sorted, and every neighbor of a kept vertex is kept, so degrees carry over.
+// Vertex blocks count what they keep, a prefix sum over blocks places each one in the output, and the
+// blocks then write their offsets and renumbered edges to the file in parallel with pwrite.
+#define EXTRACT_BUFFER 65536 // staged entries per pwrite
 
-    free(g->edges);
-    free(g->offsets);
-    free(g->labels);
-    free(g);
-}
-void saveBinGraph(Graph* g, const char* filename) {
-    
-    FILE* f = fopen(filename, "wb");
-    
-    if (!f){
-        return;
-    }
-    fwrite(&g->vertices, sizeof(int), 1, f);
-    fwrite(&g->num_edges, sizeof(long long), 1, f);
-    fwrite(g->offsets, sizeof(long long), g->vertices + 1, f);
-    fwrite(g->edges, sizeof(int), g->num_edges, f);
-    fclose(f);
-    printf("Saved binary file: %s\n", filename);
+typedef struct SizeRank{
+    vertex_t size;
+    vertex_t comp;
+}SizeRank;
+
+int compareSizeRank(const void *a, const void *b){ // Larger first, then the lower component id
+    const SizeRank *x = a;
+    const SizeRank *y = b;
+
+    if(x->size != y->size){
+        return (x->size < y->size) - (x->size > y->size);
+    }
+    return (x->comp > y->comp) - (x->comp < y->comp);
 }
 
-Graph* loadBinGraph(const char* filename) {
-    
-    FILE* f = fopen(filename, "rb");
-    
-    if (!f) return NULL;
-    
-    int n;
-    long long num_edges;
-    
-    if (fread(&n, sizeof(int), 1, f) != 1) {
-        fclose(f);
+unsigned char *selectComponents(Components* c, const char* selection, vertex_t* selected){ // keep[i] for every compacted component, NULL on a bad selection
+
+    long long k = 0;
+    long long min_size = 0;
+
+    if(strcmp(selection, "largest") == 0){
+        k = 1;
+    }
+    else if(sscanf(selection, "top:%lld", &k) == 1 && k > 0){
+    }
+    else if(sscanf(selection, "min:%lld", &min_size) == 1 && min_size > 0){
+    }
+    else{
+        printf("Unknown selection %s (largest, top:K, min:S)\n", selection);
         return NULL;
+    }
+
+    unsigned char *keep = calloc(c->count ? c->count : 1, 1);
+
+    if(!keep){
+        printf("NOT ENOUGH MEMORY\n");
+        exit(1);
+    }
+    *selected = 0;
+
+    if(min_size > 0){
+        for(vertex_t i = 0; i < c->count; i++){
+            keep[i] = c->sizes[i] >= min_size;
+            *selected += keep[i];
         }
-    
-    if (fread(&num_edges, sizeof(long long), 1, f) != 1) { 
-        fclose(f);
-        return NULL; 
+        return keep;
     }
 
+    SizeRank *rank = malloc((c->count ? c->count : 1) * sizeof(SizeRank));
 
-    Graph* g = createGraph(n);
-    
-    g->num_edges = num_edges;
-    g->edges = malloc(num_edges * sizeof(int));
-    
-    fread(g->offsets, sizeof(long long), n + 1, f);
-    fread(g->edges, sizeof(int), num_edges, f);
-    
-    fclose(f);
-    return g;
-}
-Graph *readMTX(const char* filename){
-    FILE* f = fopen(filename, "r");
+    if(!rank){
+        printf("NOT ENOUGH MEMORY\n");
+        exit(1);
+    }
+    for(vertex_t i = 0; i < c->count; i++){
+        rank[i].size = c->sizes[i];
+        rank[i].comp = i;
+    }
+    qsort(rank, c->count, sizeof(SizeRank), compareSizeRank);
 
-    if(!f){
-        return NULL;
+    for(vertex_t i = 0; i < c->count && i < k; i++){
+        keep[rank[i].comp] = 1;
+        (*selected)++;
     }
-    
-    char line[1024]; // to skip comments in mtx files
-    
-    while(fgets(line, sizeof(line), f)){
-        if(line[0] != '%'){
-            break;
+    free(rank);
+    return keep;
+}
+
+bool writeAt(int fd, const void *buf, size_t bytes, off_t at){
+
+    const char *p = buf;
+
+    while(bytes > 0){
+        ssize_t done = pwrite(fd, p, bytes, at);
+
+        if(done <= 0){
+            return false;
         }
+        p += done;
+        bytes -= done;
+        at += done;
     }
+    return true;
+}
 
-    int rows , cols;
-    long long nnz;
-    
-    if(sscanf(line, "%d %d %lld", &rows, &cols, &nnz) != 3){
-        fclose(f);
-        return NULL;
+bool extractComponents(Graph* g, Components* c, const char* selection, const char* filename){
+
+    double start = omp_get_wtime();
+    vertex_t selected;
+    unsigned char *keep = selectComponents(c, selection, &selected);
+
+    if(!keep){
+        return false;
     }
-    
-    int n = (rows > cols) ? rows : cols;
-    
-    Graph *g = createGraph(n);
-    long data_start = ftell(f);
-    int *temp = calloc(n, sizeof(int));
-    
-    if(!temp){
-        fclose(f);
-        return NULL;
+
+    vertex_t n = g->vertices;
+    int blocks = 8 * omp_get_max_threads();
+    vertex_t *new_id = malloc((n ? n : 1) * sizeof(vertex_t));
+    vertex_t *vertex_start = calloc(blocks + 1, sizeof(vertex_t));
+    long long *edge_start = calloc(blocks + 1, sizeof(long long));
+
+    if(!new_id || !vertex_start || !edge_start){
+        printf("NOT ENOUGH MEMORY\n");
+        exit(1);
     }
-     
-    long long count = 0;
-    
-    while(count < nnz && fgets(line, sizeof(line), f)){
-        
-        int u , v;
-        
-        if(sscanf(line, "%d %d", &u, &v) == 2){
-            u--; v--; 
-            if (u >= n || v >= n){
-                continue;
-            }
-            if (u == v){
-                continue;
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for(int b = 0; b < blocks; b++){
+        vertex_t kept = 0;
+        long long kept_edges = 0;
+
+        for(vertex_t v = (long long)n * b / blocks; v < (long long)n * (b + 1) / blocks; v++){
+            if(keep[c->comp[v]]){
+                kept++;
+                kept_edges += g->offsets[v + 1] - g->offsets[v];
             }
-            temp[u]++;
-            temp[v]++;            
-            count++;
         }
+        vertex_start[b + 1] = kept;
+        edge_start[b + 1] = kept_edges;
     }
-    g->offsets[0] = 0;
-    
-    for(int i =1; i <= n; i++){
-        g->offsets[i] = g->offsets[i-1] + temp[i-1];
+    for(int b = 0; b < blocks; b++){
+        vertex_start[b + 1] += vertex_start[b];
+        edge_start[b + 1] += edge_start[b];
     }
-    
-    g->num_edges = g->offsets[n];
-    g->edges = malloc(g->num_edges * sizeof(int));
-    
-    if(!g->edges){
-        printf("NOT ENOUGH MEMORY\n");
-        free(temp);
-        fclose(f);
-        return NULL;
+
+    vertex_t out_n = vertex_start[blocks];
+    long long out_m = edge_start[blocks];
+
+    char name[512];
+    char tmp_name[520];
+    snprintf(name, sizeof(name), "%s.%s" BIN_SUFFIX, filename, selection);
+    snprintf(tmp_name, sizeof(tmp_name), "%s.tmp", name); // renamed into place so a live mmap never sees a partial file
+
+    int fd = open(tmp_name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    off_t offsets_at = sizeof(vertex_t) + sizeof(long long);
+    off_t edges_at = offsets_at + (off_t)(out_n + 1) * sizeof(long long);
+    bool ok = fd != -1
+           && writeAt(fd, &out_n, sizeof(vertex_t), 0)
+           && writeAt(fd, &out_m, sizeof(long long), sizeof(vertex_t))
+           && writeAt(fd, &out_m, sizeof(long long), edges_at - sizeof(long long)) // offsets[out_n]
+           && ftruncate(fd, edges_at + (off_t)out_m * sizeof(vertex_t)) == 0;
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for(int b = 0; b < blocks; b++){ // ids first, edges may point into any block
+        vertex_t next = vertex_start[b];
+
+        for(vertex_t v = (long long)n * b / blocks; v < (long long)n * (b + 1) / blocks; v++){
+            new_id[v] = keep[c->comp[v]] ? next++ : -1;
+        }
     }
-    
-    rewind(f);
-    fseek(f, data_start, SEEK_SET); 
-    
-    for(int i= 0; i <n; i++){
-        temp[i] = 0;
+
+    if(!ok){
+        blocks = 0;
     }
 
-    count = 0;
+    #pragma omp parallel for schedule(dynamic, 1) reduction(&&:ok)
+    for(int b = 0; b < blocks; b++){
 
-    while(count < nnz && fgets(line, sizeof(line), f)){
-        
-        int u, v;
-        
-        if(sscanf(line, "%d %d", &u, &v) == 2){
-            u--;
-            v--; 
-            if (u >= n || v >= n){
-                continue;
-            } 
-            if (u == v) {
+        long long *offsets_out = malloc(EXTRACT_BUFFER * sizeof(long long));
+        vertex_t *edges_out = malloc(EXTRACT_BUFFER * sizeof(vertex_t));
+        vertex_t id = vertex_start[b];
+        long long offset = edge_start[b];
+        int staged_offsets = 0;
+        int staged_edges = 0;
+        long long edges_flushed = edge_start[b];
+
+        ok = ok && offsets_out && edges_out;
+
+        for(vertex_t v = (long long)n * b / blocks; ok && v < (long long)n * (b + 1) / blocks; v++){
+
+            if(new_id[v] < 0){
                 continue;
             }
-            
-            int u1 = g->offsets[u] + temp[u]++;
-            g->edges[u1] = v;
-            
-            int v1 = g->offsets[v] + temp[v]++;
-            g->edges[v1] = u;
-            
-            count++;
+            offsets_out[staged_offsets++] = offset;
+            offset += g->offsets[v + 1] - g->offsets[v];
+
+            if(staged_offsets == EXTRACT_BUFFER){
+                ok = writeAt(fd, offsets_out, staged_offsets * sizeof(long long), offsets_at + (off_t)(id + 1 - staged_offsets) * sizeof(long long));
+                staged_offsets = 0;
+            }
+            id++;
+
+            for(edge_t k = g->offsets[v]; ok && k < g->offsets[v + 1]; k++){
+                edges_out[staged_edges++] = new_id[g->edges[k]];
+
+                if(staged_edges == EXTRACT_BUFFER){
+                    ok = writeAt(fd, edges_out, staged_edges * sizeof(vertex_t), edges_at + (off_t)edges_flushed * sizeof(vertex_t));
+                    edges_flushed += staged_edges;
+                    staged_edges = 0;
+                }
+            }
         }
+        ok = ok && writeAt(fd, offsets_out, staged_offsets * sizeof(long long), offsets_at + (off_t)(id - staged_offsets) * sizeof(long long));
+        ok = ok && writeAt(fd, edges_out, staged_edges * sizeof(vertex_t), edges_at + (off_t)edges_flushed * sizeof(vertex_t));
+        free(offsets_out);
+        free(edges_out);
+    }
+
+    if(fd != -1){
+        ok = (close(fd) == 0) && ok;
     }
-    free(temp);
-    fclose(f);
-    return g;
+    if(ok){
+        rename(tmp_name, name);
+        printf("Extracted %lld components (%s): %lld vertices, %lld edges in %f seconds\n",
+               (long long)selected, selection, (long long)out_n, out_m, omp_get_wtime() - start);
+        printf("Saved binary file: %s\n", name);
+    }
+    else{
+        unlink(tmp_name);
+        printf("Failed to write %s\n", name);
+    }
+    free(keep);
+    free(new_id);
+    free(vertex_start);
+    free(edge_start);
+    return ok;
 }
-void ColoringAlgorithm(Graph* g){
 
-    int n = g->vertices;
-    int * labels = g->labels;
-    long long * offsets = g->offsets;
-    int * edges = g->edges;
+typedef struct GraphRun{ // One graph's results, printed in full for a single run or as one line in batch mode
+    Graph *g;
+    Components *c;
+    cc_result res;
+    const char *engine;         // the engine that ran, the pick when --engine auto
+    AutoChoice choice;          // --engine auto: the pre-analysis behind the pick
+    vertex_t largest;
+    int iterations;
+    double load_time;
+    double compute_time;
+    double stats_time;
+    double wall_time;           // load to statistics, a background cache write included
+    bool parsed;                // no cache yet, the input was parsed
+    bool seeded;                // --pipeline: the union-find gave the final labels, no engine ran
+    Pipeline pipe;              // --pipeline: the union-find that ran alongside the parse
+    CacheWriter writer;         // --pipeline: the background cache write
+}GraphRun;
 
-    #pragma omp parallel for
-    for(int i=0;i<n;i++){
-        labels[i] = i;
-    }
+bool use_pipeline = false; // --pipeline
 
-    bool changed = true;
+int prefetch_distance = CC_PREFETCH_AUTO; // --prefetch: edges the neighbour-label prefetch runs ahead, 0 is off
 
-    while(changed){
+bool runEngine(const char* filename, const char* engine, Graph *g, GraphRun *r){ // Picks the engine and runs it over g
 
-        changed = false;
+    cc_options opt;
 
-        #pragma omp parallel for schedule(dynamic, 512) reduction(||:changed)
-        for(int v=0;v<n;v++){
-            
-            long long start = g->offsets[v];
-            long long end = g->offsets[v+1];
+    cc_default_options(&opt);
+    r->engine = engine;
 
-            for(long long k = start; k < end; k++){
-                
-                int u = g->edges[k];
-                
-                if(g->labels[v] > g->labels[u]){
-                    g->labels[v] = g->labels[u];
-                    changed = true;
-                }
-            }
+    if(strcmp(engine, "auto") == 0){
+        if(!autoAnalyze(filename, g, &r->choice)){
+            printf("NOT ENOUGH MEMORY\n");
+            return false;
         }
+        r->engine = r->choice.engine;
+        opt.chunk = r->choice.chunk;
+        opt.threads = (r->choice.threads < omp_get_max_threads()) ? r->choice.threads : omp_get_max_threads();
     }
-}
+    opt.engine = r->engine;
+    opt.on_iteration = onIteration;
+    opt.prefetch = prefetch_distance;
 
-    
+    const char *block_kb = getenv("CC_BLOCK_KB"); // engine blocked: override the LLC-derived block size
 
-int main(int argc, char* argv[]){
-    
-    if(argc < 2){
-        printf("opening: %s <matrix_file.mtx>\n", argv[0]);
-        return 1;
+    if(block_kb){
+        opt.block_bytes = atoll(block_kb) * 1024;
     }
-    
+
+    int status = cc_components(g->vertices, g->offsets, g->edges, g->labels, &opt, &r->res);
+
+    if(status != CC_OK){
+        printf("%s: %s\n", filename, cc_strerror(status));
+        return false;
+    }
+    return true;
+}
+
+bool runGraph(const char* filename, const char* engine, GraphRun *r){ // Load from the cache or parse, then compute and collect statistics
+
     char bin_name[256];
-    snprintf(bin_name, sizeof(bin_name), "%s.bin", argv[1]);
+
+    snprintf(bin_name, sizeof(bin_name), "%s" BIN_SUFFIX, filename);
+    TRACE(memset(trace.phase, 0, sizeof(trace.phase)));
+    TRACE(double phase_start = traceTime());
+    double load_start = omp_get_wtime();
     Graph* g = loadBinGraph(bin_name);
+    TRACE(if(g) trace.phase[PHASE_LOAD_CACHE] = traceTime() - phase_start);
+    bool seeded = false;
+
+    memset(&r->writer, 0, sizeof(CacheWriter));
+    r->parsed = !g;
     
     if(!g){
-        g = readMTX(argv[1]);
+        pipeline = use_pipeline ? &r->pipe : NULL;
+        g = readMTX(filename);
         
         if(!g){
-            printf("Failed to load graph from %s\n", argv[1]);
-            return 1;
+            return false;
+        }
+        if(use_pipeline){
+            seeded = pipelineSeed(pipeline, g);
+            cacheWriteStart(&r->writer, g, bin_name);
+        }
+        else{
+            TRACE(phase_start = traceTime());
+            saveBinGraph(g, bin_name);
+            TRACE(trace.phase[PHASE_CACHE_WRITE] = traceTime() - phase_start);
         }
-        saveBinGraph(g, bin_name);
     }
     else{
         printf("Loaded binary file: %s\n", bin_name);
     }
+    r->load_time = omp_get_wtime() - load_start;
     
-    double start_time = omp_get_wtime(); // Start Timer
-    ColoringAlgorithm(g);
-    double end_time = omp_get_wtime(); // End Timer
+    perfSample("load", -1, 0);
+    TRACE(trace.threads = omp_get_max_threads());
+
+    r->seeded = seeded;
+
+    if(seeded){ // the union-find already gave the final labels, nothing to run
+        memset(&r->res, 0, sizeof(cc_result));
+        r->res.threads = omp_get_max_threads();
+        r->engine = "pipeline";
+    }
+    else if(!runEngine(filename, engine, g, r)){
+        cacheWriteWait(&r->writer);
+        freeGraph(g);
+        return false;
+    }
+    r->iterations = r->res.iterations;
+    r->compute_time = r->res.seconds;
+    perfSample("compute", -1, r->res.edges_scanned);
+    double post_start = omp_get_wtime();
+    Components* c = computeComponents(g);
+    double post_end = omp_get_wtime();
+    perfSample("stats", -1, 0);
+    r->stats_time = post_end - post_start;
+
+    r->largest = 0;
+    for(vertex_t i = 0; i < c->count; i++){
+        if(c->sizes[i] > r->largest){
+            r->largest = c->sizes[i];
+        }
+    }
+    cacheWriteWait(&r->writer);
+    TRACE(if(use_pipeline && r->parsed) trace.phase[PHASE_CACHE_WRITE] = r->writer.seconds);
+    r->wall_time = omp_get_wtime() - load_start;
+    r->g = g;
+    r->c = c;
+    TRACE(trace.phase[PHASE_COMPUTE] = r->compute_time);
+    TRACE(trace.phase[PHASE_STATS] = r->stats_time);
+    return true;
+}
+
+// Batch mode (--batch <manifest | directory>): every graph named in the manifest, one path per line with
+// '#' comments, or every graph input found in the directory, runs in this one process. The OpenMP thread
+// pool, the spare graph arena and the heap's freed temporaries carry over from graph to graph, and while
+// one graph computes a reader thread pulls the next one's binary cache (or its input when it has none yet)
+// into the page cache.
+int runBatch(const char* path, bool save_labels, bool save_csv, const char* engine, const char* extract){
+
+    int count;
+    char **names = batchList(path, &count);
+
+    if(!names){
+        printf("Failed to read batch list %s\n", path);
+        return 1;
+    }
+    if(count == 0){
+        printf("No graphs found in %s\n", path);
+        free(names);
+        return 1;
+    }
+
+    arena_recycle = true;
+    mallopt(M_MMAP_THRESHOLD, 32 << 20); // keep freed temporaries in the heap instead of unmapping them
+    mallopt(M_TRIM_THRESHOLD, 1 << 30);
+
+    Prefetch prefetch = {0};
+    int failed = 0;
+    long long total_edges = 0;
+    double load_time = 0, compute_time = 0, stats_time = 0;
+
+    double start_time = omp_get_wtime();
+
+    for(int i = 0; i < count; i++){
+
+        long long n, m;
+        const char* suffix = buildFor(names[i], &n, &m);
+
+        prefetchWait(&prefetch);
+        if(i + 1 < count){
+            prefetchStart(&prefetch, names[i + 1]);
+        }
+        if(suffix){
+            printf("%s: %lld vertices and up to %lld edges need the %s build, skipped\n", names[i], n, m, suffix);
+            failed++;
+            continue;
+        }
+
+        GraphRun r;
+
+        if(!runGraph(names[i], engine, &r)){
+            if(wider_build){
+                printf("%s: needs the %s build, skipped\n", names[i], wider_build);
+                wider_build = NULL;
+            }
+            else{
+                printf("%s: failed to load\n", names[i]);
+            }
+            failed++;
+            continue;
+        }
+        if(strcmp(engine, "auto") == 0 && !r.seeded){
+            printf("%s: auto picked %s, chunk %lld, threads %d: %s\n", names[i], r.engine, (long long)r.res.chunk, r.res.threads, r.choice.reason);
+        }
+        printf("%s: %lld vertices, %lld edges, %lld components, largest %lld, %d iterations, load %f s, compute %f s, stats %f s\n",
+               names[i], (long long)r.g->vertices, (long long)r.g->offsets[r.g->vertices], (long long)r.c->count,
+               (long long)r.largest, r.iterations, r.load_time, r.compute_time, r.stats_time);
+        fflush(stdout);
+
+        if(save_labels){
+            saveComponents(r.g, r.c, names[i], save_csv);
+        }
+        if(extract && !extractComponents(r.g, r.c, extract, names[i])){
+            failed++;
+        }
+        TRACE(traceWrite(names[i], "openmp", (long long)r.g->vertices, (long long)r.g->offsets[r.g->vertices]));
+        total_edges += r.g->offsets[r.g->vertices];
+        load_time += r.load_time;
+        compute_time += r.compute_time;
+        stats_time += r.stats_time;
+        freeComponents(r.c);
+        freeGraph(r.g);
+    }
+    prefetchWait(&prefetch);
+
+    double elapsed = omp_get_wtime() - start_time;
+    int done = count - failed;
+
+    printf("Batch: %d graphs (%d failed) in %f seconds, %.2f graphs/s, %.0f edges/s\n",
+           done, failed, elapsed, elapsed > 0 ? done / elapsed : 0.0, elapsed > 0 ? total_edges / elapsed : 0.0);
+    printf("Batch time: load %f s, compute %f s, stats %f s, threads %d, engine %s\n", load_time, compute_time, stats_time,
+           omp_get_max_threads(), engine);
+
+    for(int i = 0; i < count; i++){
+        free(names[i]);
+    }
+    free(names);
+    return failed ? 1 : 0;
+}
+
+void ompParallel(int pieces, void (*piece)(void *ctx, int i), void *ctx){ // parallel.run for the shared loading code
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for(int i = 0; i < pieces; i++){
+        piece(ctx, i);
+    }
+}
+
+int main(int argc, char* argv[]){
     
+    if(argc < 2 || (strcmp(argv[1], "--batch") == 0 && argc < 3)){
+        printf("opening: %s <matrix_file.mtx[.gz] | edge_list.txt[.gz] | archive.tar.gz> [--labels] [--csv] [--perf] [--perf-iter] [--engine lp|peel|blocked|contract|auto]\n"
+               "         [--extract largest|top:K|min:S] [--prefetch auto|<distance>] [--pipeline]\n", argv[0]);
+        printf("         %s --batch <manifest.txt | directory> [--labels] [--csv] [--perf] [--engine lp|peel|blocked|contract|auto] [--extract ...] [--prefetch auto|<distance>]\n"
+               "         [--pipeline]\n", argv[0]);
+        return 1;
+    }
+    const char* batch = (strcmp(argv[1], "--batch") == 0) ? argv[2] : NULL;
 
-    int num_components = 0;
-    for(int i=0; i<g->vertices; i++){
-        if(g->labels[i] == i){
-            num_components++;
+    if(!batch){
+        selectBuild(argv);
+    }
+
+    bool save_labels = false;
+    bool save_csv = false;
+    bool use_perf = false;
+    const char* engine = "lp";
+    const char* extract = NULL;
+
+    for(int i = batch ? 3 : 2; i < argc; i++){
+        if(strcmp(argv[i], "--labels") == 0){
+            save_labels = true;
+        }
+        else if(strcmp(argv[i], "--csv") == 0){
+            save_labels = true;
+            save_csv = true;
+        }
+        else if(strcmp(argv[i], "--perf") == 0){
+            use_perf = true;
+        }
+        else if(strcmp(argv[i], "--perf-iter") == 0){
+            use_perf = true;
+            perf.per_iteration = true;
+        }
+        else if(strcmp(argv[i], "--engine") == 0 && i + 1 < argc){
+            i++;
+            if(strcmp(argv[i], "lp") != 0 && strcmp(argv[i], "peel") != 0 && strcmp(argv[i], "blocked") != 0 && strcmp(argv[i], "contract") != 0 &&
+               strcmp(argv[i], "auto") != 0){
+                printf("Unknown engine %s (lp, peel, blocked, contract, auto)\n", argv[i]);
+                return 1;
+            }
+            engine = argv[i];
+        }
+        else if(strcmp(argv[i], "--extract") == 0 && i + 1 < argc){
+            extract = argv[++i];
+        }
+        else if(strcmp(argv[i], "--prefetch") == 0 && i + 1 < argc){
+            i++;
+            prefetch_distance = (strcmp(argv[i], "auto") == 0) ? CC_PREFETCH_AUTO : atoi(argv[i]);
+        }
+        else if(strcmp(argv[i], "--pipeline") == 0){
+            use_pipeline = true;
         }
     }
-    printf("Total Vertices: %d\n", g->vertices);
-    printf("Number of Connected Components: %d\n", num_components);
-    printf("Time taken: %f seconds\n", end_time - start_time);
+
+    parallel.threads = omp_get_max_threads();
+    parallel.run = ompParallel;
+
+    if(use_perf){
+        #pragma omp parallel // start the thread pool so its threads get counters
+        {
+        }
+        perfOpen();
+    }
+    
+    if(batch){
+        int status = runBatch(batch, save_labels, save_csv, engine, extract);
+
+        perfClose();
+        return status;
+    }
+
+    GraphRun r;
+
+    if(!runGraph(argv[1], engine, &r)){
+        if(wider_build){
+            execBuild(argv, wider_build);
+        }
+        printf("Failed to load graph from %s\n", argv[1]);
+        return 1;
+    }
+    Graph* g = r.g;
+    Components* c = r.c;
+
+    printf("Total Vertices: %lld\n", (long long)g->vertices);
+    printf("Total Edges: %lld\n", (long long)g->offsets[g->vertices]);
+    printf("Graph arena: %.1f MB on %s pages\n", g->arena.used / 1048576.0, g->arena.backing);
+    printf("Threads: %d\n", r.res.threads);
+    if(r.res.prefetch > 0){
+        printf("Label prefetch: %d edges ahead\n", r.res.prefetch);
+    }
+    else{
+        printf("Label prefetch: off\n");
+    }
+    if(strcmp(engine, "auto") == 0 && !r.seeded){
+        autoReport(argv[1], &r.choice);
+        printf("Auto: engine %s, chunk %lld, threads %d: %s\n", r.engine, (long long)r.res.chunk, r.res.threads, r.choice.reason);
+    }
+    printf("Engine: %s\n", r.engine);
+    printf("Number of Connected Components: %lld\n", (long long)c->count);
+    printf("Largest Component: %lld vertices\n", (long long)r.largest);
+    if(strcmp(r.engine, "peel") == 0){
+        printf("Peel: %lld vertices (%.1f%%) from root %lld in %d BFS levels (%d bottom-up)\n",
+               (long long)r.res.peeled, g->vertices ? 100.0 * r.res.peeled / g->vertices : 0.0, (long long)r.res.peel_root,
+               r.res.bfs_levels, r.res.bottom_up_levels);
+    }
+    if(strcmp(r.engine, "blocked") == 0){
+        printf("Blocked: %lld blocks of ~%.0f KB, %lld block sweeps, ~%.1f MB from DRAM (%.1f MB per round, modelled)\n",
+               r.res.blocks, r.res.blocks ? ((double)g->offsets[g->vertices] * sizeof(vertex_t) + (double)g->vertices * (sizeof(edge_t) + sizeof(vertex_t))) / r.res.blocks / 1024.0 : 0.0,
+               r.res.block_sweeps, r.res.dram_bytes / 1e6, r.res.iterations ? r.res.dram_bytes / r.res.iterations / 1e6 : 0.0);
+    }
+    if(strcmp(r.engine, "contract") == 0){
+        printf("Contract: %d levels, %.0f edges scanned (%.2fx the input)\n", r.res.levels, r.res.edges_scanned,
+               g->offsets[g->vertices] ? r.res.edges_scanned / g->offsets[g->vertices] : 0.0);
+    }
+    printf("Iterations: %d\n", r.iterations);
+    printf("Time taken: %f seconds\n", r.compute_time);
+    printf("Component statistics time: %f seconds\n", r.stats_time);
+    if(use_pipeline){
+        pipelineReport(&r.pipe, &r.writer, r.parsed);
+    }
+    printf("End to end: %f seconds (load %f, compute %f, stats %f)\n", r.wall_time, r.load_time, r.compute_time, r.stats_time);
+
+    if(save_labels){
+        saveComponents(g, c, argv[1], save_csv);
+    }
+
+    bool extracted = !extract || extractComponents(g, c, extract, argv[1]);
+
+    TRACE(traceWrite(argv[1], "openmp", (long long)g->vertices, (long long)g->offsets[g->vertices]));
+    perfClose();
+    freeComponents(c);
     freeGraph(g);
-    return 0;
-}
\ No newline at end of file
+    return extracted ? 0 : 1;
+}
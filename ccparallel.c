@@ -0,0 +1,31 @@
+#include <stdlib.h>
+#include "ccparallel.h"
+
+Parallel parallel = {1, NULL};
+
+typedef struct Ranges{
+    long long n;
+    int pieces;
+    void (*body)(void *ctx, long long begin, long long end);
+    void *ctx;
+}Ranges;
+
+void rangePiece(void *arg, int i){
+
+    Ranges *r = (Ranges*)arg;
+
+    r->body(r->ctx, r->n * i / r->pieces, r->n * (i + 1) / r->pieces);
+}
+
+void parallelFor(long long n, int split, void (*body)(void *ctx, long long begin, long long end), void *ctx){
+
+    int pieces = (parallel.threads > 1 ? parallel.threads : 1) * (split > 1 ? split : 1);
+
+    if(!parallel.run || pieces == 1 || n < pieces){ // too little to be worth waking the threads
+        body(ctx, 0, n);
+        return;
+    }
+    Ranges r = {n, pieces, body, ctx};
+
+    parallel.run(pieces, rangePiece, &r);
+}
@@ -0,0 +1,20 @@
+#ifndef CCPARALLEL_H
+#define CCPARALLEL_H
+
+// Parallel loops for the code the backends share (first touch, arena reuse, CSR build, cache load). Each
+// backend runs them on its own threads by filling in parallel at startup: run must call piece(ctx, i) once
+// for every i in [0, pieces), spreading them over up to threads threads (the pthreads pool, an OpenMP loop,
+// cilk_for). Without run, as in the sequential backend, every loop runs in order on the calling thread.
+
+typedef struct Parallel{
+    int threads;
+    void (*run)(int pieces, void (*piece)(void *ctx, int i), void *ctx);
+}Parallel;
+
+extern Parallel parallel;
+
+// Calls body(ctx, begin, end) over [0, n) cut into contiguous ranges, split of them per thread: 1 gives
+// every thread one range, for first touch; more balance loops whose iterations differ in cost.
+void parallelFor(long long n, int split, void (*body)(void *ctx, long long begin, long long end), void *ctx);
+
+#endif
@@ -0,0 +1,195 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "ccperf.h"
+
+const struct { uint32_t type; uint64_t config; const char* name; } perf_events[NUM_EVENTS] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, "cycles"},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, "instructions"},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, "LLC misses"},
+    {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16), "dTLB misses"},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, "branch misses"},
+    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK, "task clock"},
+    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS, "page faults"},
+};
+
+PerfCounters perf = {0};
+
+int perfOpenEvent(int e, pid_t tid, int group, bool inherit){
+
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = perf_events[e].type;
+    attr.config = perf_events[e].config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.inherit = inherit;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(SYS_perf_event_open, &attr, tid, -1, group, 0);
+}
+
+void perfOpenThread(pid_t tid, bool inherit){
+
+    int leader = -1;
+
+    for(int e = 0; e < NUM_EVENTS && perf.num_fds < MAX_PERF_FDS; e++){
+
+        bool hardware = perf_events[e].type != PERF_TYPE_SOFTWARE;
+
+        if(hardware && !perf.hardware){
+            continue;
+        }
+        int fd = perfOpenEvent(e, tid, hardware ? leader : -1, inherit);
+
+        if(fd < 0){ // e.g. no dTLB event on this CPU, the rest still count
+            continue;
+        }
+        if(e == EV_CYCLES){
+            leader = fd;
+        }
+        perf.available[e] = true;
+        perf.fd[perf.num_fds] = fd;
+        perf.event[perf.num_fds] = e;
+        perf.num_fds++;
+    }
+}
+
+void perfRead(double *values){
+
+    memset(values, 0, NUM_EVENTS * sizeof(double));
+
+    for(int i = 0; i < perf.num_fds; i++){
+
+        uint64_t buf[3]; // value, time enabled, time running
+
+        if(read(perf.fd[i], buf, sizeof(buf)) == sizeof(buf) && buf[2] > 0){
+            values[perf.event[i]] += (double)buf[0] * buf[1] / buf[2];
+        }
+    }
+    if(perf.combine){ // summed over the processes onto the reporting one
+        perf.combine(values, NUM_EVENTS, false);
+    }
+}
+
+void perfOpen(){
+
+    int probe = perfOpenEvent(EV_CYCLES, 0, -1, false);
+
+    perf.hardware = probe >= 0;
+
+    if(probe >= 0){
+        close(probe);
+    }
+    else if(!perf.quiet){
+        printf("Hardware counters unavailable (%s), reporting software counters only\n", strerror(errno));
+    }
+
+    pid_t self = (pid_t)syscall(SYS_gettid);
+    perfOpenThread(self, true);
+
+    DIR* dir = opendir("/proc/self/task");
+    struct dirent* ent;
+
+    while(dir && (ent = readdir(dir))){
+        pid_t tid = (pid_t)atoi(ent->d_name);
+        if(tid > 0 && tid != self){
+            perfOpenThread(tid, false);
+        }
+    }
+    if(dir){
+        closedir(dir);
+    }
+    int error = errno;
+    perf.enabled = perf.num_fds > 0;
+
+    if(perf.combine){ // every process must count the same events, or the sums mix different sets
+
+        double opened[NUM_EVENTS + 1];
+
+        for(int e = 0; e < NUM_EVENTS; e++){
+            opened[e] = perf.available[e];
+        }
+        opened[NUM_EVENTS] = perf.enabled;
+        perf.combine(opened, NUM_EVENTS + 1, true);
+
+        for(int e = 0; e < NUM_EVENTS; e++){
+            perf.available[e] = opened[e] > 0;
+        }
+        perf.enabled = opened[NUM_EVENTS] > 0;
+    }
+    if(!perf.enabled){
+        if(!perf.quiet){
+            printf("Performance counters unavailable (%s)\n", perf.num_fds > 0 ? "not on every process" : strerror(error));
+        }
+        return;
+    }
+    perfRead(perf.phase_last);
+    memcpy(perf.iter_last, perf.phase_last, sizeof(perf.iter_last));
+}
+
+void perfClose(){
+    for(int i = 0; i < perf.num_fds; i++){
+        close(perf.fd[i]);
+    }
+    perf.num_fds = 0;
+    perf.enabled = false;
+}
+
+void perfSample(const char* label, int iteration, double edges){
+
+    if(!perf.enabled){
+        return;
+    }
+
+    double now[NUM_EVENTS];
+    double d[NUM_EVENTS];
+    double *last = (iteration >= 0) ? perf.iter_last : perf.phase_last;
+
+    perfRead(now);
+
+    for(int e = 0; e < NUM_EVENTS; e++){
+        d[e] = now[e] - last[e];
+    }
+    memcpy(perf.iter_last, now, sizeof(now));
+    if(iteration < 0){
+        memcpy(perf.phase_last, now, sizeof(now));
+    }
+    if(perf.quiet){
+        return;
+    }
+
+    printf("Counters %s", label);
+    if(iteration >= 0){
+        printf(" %d", iteration);
+    }
+    printf(":");
+
+    if(perf.available[EV_CYCLES] && perf.available[EV_INSTRUCTIONS]){
+        printf(" cycles %.3e, instructions %.3e, IPC %.2f,", d[EV_CYCLES], d[EV_INSTRUCTIONS],
+               d[EV_CYCLES] > 0 ? d[EV_INSTRUCTIONS] / d[EV_CYCLES] : 0.0);
+    }
+    for(int e = EV_CYCLES; e <= EV_BRANCH_MISSES; e++){
+        if(!perf.hardware){
+            break;
+        }
+        if(!perf.available[e]){
+            printf(" %s n/a,", perf_events[e].name);
+        }
+        else if(edges > 0){
+            printf(" %s/edge %.3f,", perf_events[e].name, d[e] / edges);
+        }
+        else if(e >= EV_LLC_MISSES){
+            printf(" %s %.3e,", perf_events[e].name, d[e]);
+        }
+    }
+    printf(" task clock %.3f s, page faults %.0f\n", d[EV_TASK_CLOCK] / 1e9, d[EV_PAGE_FAULTS]);
+}
+
@@ -0,0 +1,42 @@
+#ifndef CCPERF_H
+#define CCPERF_H
+
+// Hardware counters (--perf, --perf-iter), shared by every backend: a counter set is opened for every
+// thread alive when perfOpen runs (the OpenMP/Cilk pools are started first) plus an inherited set on the
+// calling thread, which picks up threads created later once they are joined. Hardware events form one
+// group led by cycles; values are scaled for multiplexing. Without PMU access only software events count.
+//
+// A multi-process run (the MPI build) sets combine before perfOpen: it is called by every process with
+// the local values and must leave the sum over processes (min: the minimum) in the caller's buffer on the
+// reporting process. perfOpen and perfSample are then collective, and quiet processes print nothing.
+
+#include <stdbool.h>
+
+#define MAX_PERF_FDS 1024
+
+enum { EV_CYCLES, EV_INSTRUCTIONS, EV_LLC_MISSES, EV_DTLB_MISSES, EV_BRANCH_MISSES, EV_TASK_CLOCK, EV_PAGE_FAULTS, NUM_EVENTS };
+
+typedef struct PerfCounters{
+    bool enabled;
+    bool per_iteration;
+    bool hardware;
+    bool available[NUM_EVENTS];
+    int num_fds;
+    int fd[MAX_PERF_FDS];
+    int event[MAX_PERF_FDS];
+    double phase_last[NUM_EVENTS];  // totals at the previous phase boundary
+    double iter_last[NUM_EVENTS];   // totals at the previous iteration boundary
+    void (*combine)(double *values, int count, bool min);
+    bool quiet;
+}PerfCounters;
+
+extern PerfCounters perf;
+
+void perfOpen();
+void perfClose();
+
+// Prints what was counted since the previous phase (iteration < 0) or iteration boundary, normalised
+// per edge processed when edges > 0.
+void perfSample(const char* label, int iteration, double edges);
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef CCPREFETCH_H
+#define CCPREFETCH_H
+
+#include <unistd.h>
+
+// Software prefetch of the labels[edges[k]] gathers. The hardware prefetchers follow edges[] but not the
+// labels it points into, so a sweep runs a second edge cursor a prefetch distance ahead of the one it scans
+// and prefetches the label under it. The cursor walks the same vertex sequence as the sweep (a range, a
+// stride or an active list), so the lookahead carries on across vertex boundaries instead of stalling on
+// low degrees. Labels that fit in L2 are gathered at cache latency already and the cursor only costs, so
+// PREFETCH_AUTO turns it on for graphs whose labels do not. Shared by the backends' own kernels and libcc;
+// include it after vertex_t and edge_t are defined.
+#define PREFETCH_AUTO (-1)          // same value as libcc's CC_PREFETCH_AUTO
+#define PREFETCH_DISTANCE 16
+#define PREFETCH_DEFAULT_L2 (1L << 20)
+
+typedef struct Lookahead{
+    const edge_t *offsets;
+    const vertex_t *edges;
+    const vertex_t *labels;
+    const vertex_t *active;     // vertex at position i is active[i], or i itself when NULL
+    vertex_t stop;
+    vertex_t step;
+    vertex_t i;
+    edge_t k;
+    edge_t end;
+}Lookahead;
+
+static inline int resolvePrefetch(int option, long long n){ // Edges to run ahead for a graph of n vertices, option is --prefetch
+
+    if(option != PREFETCH_AUTO){
+        return (option > 0) ? option : 0;
+    }
+
+    long l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+
+    if(l2 <= 0){
+        l2 = PREFETCH_DEFAULT_L2;
+    }
+    return (n * (long long)sizeof(vertex_t) > l2) ? PREFETCH_DISTANCE : 0;
+}
+
+static inline __attribute__((always_inline)) void lookaheadStep(Lookahead *a){ // Prefetches the label of the next edge in the sequence
+
+    while(a->k == a->end){
+        if(a->i >= a->stop){
+            return;
+        }
+        vertex_t v = a->active ? a->active[a->i] : a->i;
+
+        a->i += a->step;
+        a->k = a->offsets[v];
+        a->end = a->offsets[v + 1];
+    }
+    __builtin_prefetch(&a->labels[a->edges[a->k++]]);
+}
+
+static inline void lookaheadStart(Lookahead *a, vertex_t i, int distance){ // (Re)starts the cursor at position i, distance edges ahead
+
+    a->i = i;
+    a->k = 0;
+    a->end = 0;
+
+    for(int d = 0; d < distance; d++){
+        lookaheadStep(a);
+    }
+}
+
+#endif
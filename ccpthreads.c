@@ -1,295 +1,805 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <string.h>
+#include <strings.h>
 #include <time.h>
+#include <sys/resource.h>
+#include <errno.h>
+#include <dirent.h>
+#include <zlib.h>
 #include <pthread.h>
+#include <malloc.h>
+#include "ccarena.h"
+#include "ccinput.h"
+#include "ccgraph.h"
+#include "ccparallel.h"
+#include "ccauto.h"
+#include "ccperf.h"
+#include "ccprefetch.h"
 
-#define NUM_THREADS 20
-#define CHUNK_SIZE 512
+#define STEAL_MIN_CHUNK 2048     // edges + vertices in the smallest work-stealing chunk
+#define STEAL_CHUNKS_PER_THREAD 16
 
+int num_threads = 1;            // one per online CPU or CC_NUM_THREADS, set at startup; --auto lowers it per graph
+long long steal_chunk = 0;      // --auto: work per steal chunk, 0 sizes chunks from the thread count
 
-typedef struct Graph{
-    int vertices;
-    long long num_edges;
-    int *edges;
-    long long *offsets;
-    int *labels;
-}Graph;
+// Persistent worker pool: num_threads - 1 threads are started once and parked on a condition variable.
+// poolRun hands the first num_threads of them the same job with their own slot of args, runs slot 0 on the
+// calling thread and returns when every slot is done (the rest stay parked), so sweeps, statistics and first touch no longer create and join
+// threads per call, and batch mode keeps the same workers across graphs.
+typedef struct Pool{
+    int size;               // slots, the caller included
+    int active;             // slots the current job runs on
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t finish;
+    void *(*job)(void*);
+    char *args;
+    size_t stride;
+    long generation;
+    int running;
+}Pool;
 
-typedef struct parm{ // parameters for each thread
-    int id;
-    Graph* g;
-    bool *changed;
-}parm;
+Pool pool = {0, 0, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER, NULL, NULL, 0, 0, 0};
 
-Graph * createGraph(int vertices){
-    Graph* g = malloc(sizeof(Graph));
-    
-    if(!g){
-        return NULL;
-    } 
-    g->vertices = vertices;
-    g->num_edges = 0;
-    g->edges = NULL;
-    g->offsets = calloc(vertices + 1, sizeof(long long));
-    g->labels = malloc(vertices * sizeof(int));
-    
-    for(int i = 0; i < vertices; i++){
-        g->labels[i] = i; 
+void *poolThread(void *arg){
+    int slot = (int)(intptr_t)arg;
+    long seen = 0;
+
+    pthread_mutex_lock(&pool.lock);
+    while(true){
+
+        while(pool.generation == seen){
+            pthread_cond_wait(&pool.start, &pool.lock);
+        }
+        seen = pool.generation;
+        if(slot >= pool.active){
+            continue;
+        }
+
+        void *(*job)(void*) = pool.job;
+        void *job_arg = pool.args + slot * pool.stride;
+
+        pthread_mutex_unlock(&pool.lock);
+        job(job_arg);
+        pthread_mutex_lock(&pool.lock);
+
+        if(--pool.running == 0){
+            pthread_cond_signal(&pool.finish);
+        }
     }
-    return g;
+    return NULL;
 }
 
-void freeGraph(Graph* g){
-    
-    if(!g){
-        return;
+void poolStart(int size){
+
+    pool.size = size;
+
+    for(int i = 1; i < size; i++){
+        pthread_t thread;
+
+        if(pthread_create(&thread, NULL, poolThread, (void*)(intptr_t)i) != 0){
+            printf("Failed to start worker thread %d\n", i);
+            exit(1);
+        }
+        pthread_detach(thread);
     }
-    
-    free(g->edges);
-    free(g->offsets);
-    free(g->labels);
-    free(g);
 }
 
-void saveBinGraph(Graph* g, const char* filename) {
-    
-    FILE* f = fopen(filename, "wb");
-    
-    if (!f){
-        return;
-    }
-    fwrite(&g->vertices, sizeof(int), 1, f);
-    fwrite(&g->num_edges, sizeof(long long), 1, f);
-    fwrite(g->offsets, sizeof(long long), g->vertices + 1, f);
-    fwrite(g->edges, sizeof(int), g->num_edges, f);
-    fclose(f);
-    printf("Saved binary file: %s\n", filename);
+void poolRun(void *(*job)(void*), void *args, size_t stride){ // args holds num_threads slots of stride bytes
+
+    pthread_mutex_lock(&pool.lock);
+    pool.job = job;
+    pool.args = args;
+    pool.stride = stride;
+    pool.active = (num_threads < pool.size) ? num_threads : pool.size;
+    pool.running = pool.active - 1;
+    pool.generation++;
+    pthread_cond_broadcast(&pool.start);
+    pthread_mutex_unlock(&pool.lock);
+
+    job(args);
+
+    pthread_mutex_lock(&pool.lock);
+    while(pool.running > 0){
+        pthread_cond_wait(&pool.finish, &pool.lock);
+    }
+    pthread_mutex_unlock(&pool.lock);
 }
 
-Graph* loadBinGraph(const char* filename) {
-    FILE* f = fopen(filename, "rb");
-    
-    if (!f) return NULL;
-    
-    int n;
-    long long num_edges;
-    
-    if (fread(&n, sizeof(int), 1, f) != 1) {
-        fclose(f);
-        return NULL;
-        }
-    
-    if (fread(&num_edges, sizeof(long long), 1, f) != 1) { 
-        fclose(f);
-        return NULL; 
+typedef struct pieceParm{ // parameters for each thread of a shared parallel loop
+    void (*piece)(void *ctx, int i);
+    void *ctx;
+    int pieces;
+    int *next;
+}pieceParm;
+
+void *pieceWorker(void *arg){
+    pieceParm *data = (pieceParm*)arg;
+    int i;
+
+    while((i = __atomic_fetch_add(data->next, 1, __ATOMIC_RELAXED)) < data->pieces){
+        data->piece(data->ctx, i);
     }
+    return NULL;
+}
 
-    Graph* g = createGraph(n);
-    g->num_edges = num_edges;
-    g->edges = malloc(num_edges * sizeof(int));
-    
-    fread(g->offsets, sizeof(long long), n + 1, f);
-    fread(g->edges, sizeof(int), num_edges, f);
-    fclose(f);
-    return g;
+void poolParallel(int pieces, void (*piece)(void *ctx, int i), void *ctx){ // parallel.run: the pieces go to the pool threads in turn
+    pieceParm args[num_threads];
+    int next = 0;
+
+    for(int i = 0; i < num_threads; i++){
+        args[i].piece = piece;
+        args[i].ctx = ctx;
+        args[i].pieces = pieces;
+        args[i].next = &next;
+    }
+    poolRun(pieceWorker, args, sizeof(pieceParm));
 }
 
-Graph *readMTX(const char* filename){
-    FILE* f = fopen(filename, "r");
+// Work-stealing sweeps (--sched steal, the default). A graph is cut into edge-balanced chunks: contiguous
+// vertex ranges holding about the same edges + vertices, at least STEAL_MIN_CHUNK and about
+// STEAL_CHUNKS_PER_THREAD per thread. Each thread starts a round with a run of them in its own Chase-Lev
+// deque and pops from the bottom; once it is empty it steals from the top of others, starting at a random
+// victim. No chunk is pushed during a round, so a thread that finds every deque empty is done. The deques
+// are refilled by the caller between rounds, while no worker runs.
+#define STEAL_EMPTY -1
+#define STEAL_ABORT -2 // lost a race for the last chunk, the deque may still hold work
+
+typedef struct Deque{ // Chase-Lev over a fixed task array (Le et al., weak memory models)
+    long top;
+    char pad_top[CACHE_LINE - sizeof(long)];
+    long bottom;
+    char pad_bottom[CACHE_LINE - sizeof(long)];
+    const long *tasks;
+}Deque;
 
-    if(!f){
-        return NULL;
+long dequePop(Deque *d){ // Owner end
+
+    long b = __atomic_load_n(&d->bottom, __ATOMIC_RELAXED) - 1;
+
+    __atomic_store_n(&d->bottom, b, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    long t = __atomic_load_n(&d->top, __ATOMIC_RELAXED);
+
+    if(t > b){
+        __atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELAXED);
+        return STEAL_EMPTY;
     }
-    
-    char line[1024]; // to skip comments in mtx files
-    
-    while(fgets(line, sizeof(line), f)){
-        if(line[0] != '%'){
-            break;
+    long task = d->tasks[b];
+
+    if(t == b){ // last one, race the thieves for it
+        if(!__atomic_compare_exchange_n(&d->top, &t, t + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)){
+            task = STEAL_EMPTY;
         }
+        __atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELAXED);
     }
+    return task;
+}
 
-    int rows , cols;
-    long long nnz;
-    
-    if(sscanf(line, "%d %d %lld", &rows, &cols, &nnz) != 3){
-        fclose(f);
-        return NULL;
+long dequeSteal(Deque *d){ // Thief end
+
+    long t = __atomic_load_n(&d->top, __ATOMIC_ACQUIRE);
+
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    long b = __atomic_load_n(&d->bottom, __ATOMIC_ACQUIRE);
+
+    if(t >= b){
+        return STEAL_EMPTY;
     }
-    
-    int n = (rows > cols) ? rows : cols;
-    
-    Graph *g = createGraph(n);
-    long data_start = ftell(f);
-    int *temp = calloc(n, sizeof(int));
-    
-    if(!temp){
-        fclose(f);
-        return NULL;
-    } 
-    
-    long long count = 0;
-    
-    while(count < nnz && fgets(line, sizeof(line), f)){
-        
-        int u , v;
+    long task = d->tasks[t];
+
+    if(!__atomic_compare_exchange_n(&d->top, &t, t + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)){
+        return STEAL_ABORT;
+    }
+    return task;
+}
+
+typedef struct SchedStats{ // Summed over the rounds of the last ColoringAlgorithm_threads call
+    bool steal;
+    long chunks;
+    long long steals;
+    long long failed_steals;    // attempts that found a deque empty or lost a race
+    double busy;                // thread-seconds spent sweeping
+    double idle;                // thread-seconds spent waiting for the round to end
+}SchedStats;
+
+SchedStats sched = {true, 0, 0, 0, 0, 0};
+
+typedef struct parm{ // parameters for each thread
+    int id;
+    Graph* g;
+    bool *changed;
+    vertex_t *chunk_start;      // work stealing: chunk c covers [chunk_start[c], chunk_start[c + 1])
+    Deque *deques;
+    unsigned seed;
+    long long steals;
+    long long failed_steals;
+    double busy;
+#ifdef CC_TRACE
+    long long changed_count;
+#endif
+}parm;
+
+
+int prefetch_option = PREFETCH_AUTO; // --prefetch: edges the label prefetch runs ahead, 0 is off
+int prefetch_distance = 0;           // what the current graph runs with
+
+void *worker(void *arg){
+    parm *data = (parm*)arg;
+    int id = data->id;
+    Graph* g = data->g;
+    vertex_t n = g->vertices;
+
+    bool worker_changed = false;
+    double busy_start = wallTime();
+    TRACE(data->changed_count = 0);
+
+    bool prefetch = prefetch_distance > 0;
+    Lookahead ahead = {g->offsets, g->edges, g->labels, NULL, n, num_threads};
+    lookaheadStart(&ahead, id, prefetch_distance);
+
+    for(vertex_t v = id; v<n; v += num_threads){
         
-        if(sscanf(line, "%d %d", &u, &v) == 2){
-            u--; v--; 
-            if (u >= n || v >= n){
-                continue;
+        edge_t start = g->offsets[v];
+        edge_t end = g->offsets[v+1];
+
+        for(edge_t k = start; k < end; k++){
+            vertex_t u = g->edges[k];
+            
+            if(prefetch){
+                lookaheadStep(&ahead);
             }
-            if (u == v){
-                continue;
+            if(g->labels[v] > g->labels[u]){
+                g->labels[v] = g->labels[u];
+                worker_changed = true;
+                TRACE(data->changed_count++);
             }
-            temp[u]++;
-            temp[v]++;            
-            count++;
         }
     }
+    data->busy = wallTime() - busy_start;
     
-    g->offsets[0] = 0;
-    
-    for(int i =1; i <= n; i++){
-        g->offsets[i] = g->offsets[i-1] + temp[i-1];
-    }
-    
-    g->num_edges = g->offsets[n];
-    g->edges = malloc(g->num_edges * sizeof(int));
-    
-    if(!g->edges){
-        printf("NOT ENOUGH MEMORY\n");
-        free(temp);
-        fclose(f);
-        return NULL;
-    }
-    
-    rewind(f);
-    fseek(f, data_start, SEEK_SET); 
-    
-    for(int i= 0; i <n; i++){
-        temp[i] = 0;
+    if(worker_changed){
+        *(data->changed) = true;
     }
+    return NULL;
+}
 
-    count = 0;
+bool sweepChunk(parm *data, vertex_t lo, vertex_t hi){
+    Graph* g = data->g;
+    bool chunk_changed = false;
+    bool prefetch = prefetch_distance > 0;
+    Lookahead ahead = {g->offsets, g->edges, g->labels, NULL, hi, 1};
+    lookaheadStart(&ahead, lo, prefetch_distance);
 
-    while(count < nnz && fgets(line, sizeof(line), f)){
-        
-        int u, v;
-        
-        if(sscanf(line, "%d %d", &u, &v) == 2){
-            u--;
-            v--; 
-            if (u >= n || v >= n){
-                continue;
-            } 
-            if (u == v) {
-                continue;
+    for(vertex_t v = lo; v < hi; v++){
+
+        for(edge_t k = g->offsets[v]; k < g->offsets[v+1]; k++){
+            vertex_t u = g->edges[k];
+
+            if(prefetch){
+                lookaheadStep(&ahead);
+            }
+            if(g->labels[v] > g->labels[u]){
+                g->labels[v] = g->labels[u];
+                chunk_changed = true;
+                TRACE(data->changed_count++);
             }
-            long long u1 = g->offsets[u] + temp[u]++;
-            g->edges[u1] = v;
-            long long v1 = g->offsets[v] + temp[v]++;
-            g->edges[v1] = u;
-            count++;
         }
     }
-    
-    free(temp);
-    fclose(f);
-    return g;
+    return chunk_changed;
 }
 
-void *worker(void *arg){
+void *stealWorker(void *arg){
     parm *data = (parm*)arg;
     int id = data->id;
-    Graph* g = data->g;
-    int n = g->vertices;
-
     bool worker_changed = false;
+    double busy_start = wallTime();
+    long chunk;
+    TRACE(data->changed_count = 0);
 
-    for(int v = id; v<n; v += NUM_THREADS){
-        
-        long long start = g->offsets[v];
-        long long end = g->offsets[v+1];
+    while((chunk = dequePop(&data->deques[id])) >= 0){
+        worker_changed |= sweepChunk(data, data->chunk_start[chunk], data->chunk_start[chunk + 1]);
+    }
 
-        for(long long k = start; k < end; k++){
-            int u = g->edges[k];
-            
-            if(g->labels[v] > g->labels[u]){
-                g->labels[v] = g->labels[u];
-                worker_changed = true;
+    while(true){
+
+        bool contended = false;
+        int first = rand_r(&data->seed) % num_threads;
+
+        chunk = STEAL_EMPTY;
+        for(int k = 0; k < num_threads && chunk < 0; k++){ // a random victim, then round-robin over the rest
+
+            int victim = (first + k) % num_threads;
+
+            if(victim == id){ // our own deque is already drained
+                continue;
+            }
+            long got = dequeSteal(&data->deques[victim]);
+
+            if(got >= 0){
+                chunk = got;
+                data->steals++;
+            }
+            else{
+                data->failed_steals++;
+                contended |= (got == STEAL_ABORT);
             }
         }
+        if(chunk < 0 && !contended){
+            break;
+        }
+        if(chunk >= 0){
+            worker_changed |= sweepChunk(data, data->chunk_start[chunk], data->chunk_start[chunk + 1]);
+        }
     }
-    
+    data->busy = wallTime() - busy_start;
+
     if(worker_changed){
         *(data->changed) = true;
     }
     return NULL;
 }
-void ColoringAlgorithm_threads(Graph* g){
+
+vertex_t *stealChunks(Graph* g, long *chunks){ // Edge-balanced chunk boundaries, offsets[v] + v is the work before v
+
+    vertex_t n = g->vertices;
+    long long work = (long long)g->offsets[n] + n;
+    long long target = steal_chunk ? steal_chunk : work / ((long long)num_threads * STEAL_CHUNKS_PER_THREAD);
+
+    if(target < STEAL_MIN_CHUNK){
+        target = STEAL_MIN_CHUNK;
+    }
+    long count = (work + target - 1) / target;
+
+    if(count < 1){
+        count = 1;
+    }
+    vertex_t *start = malloc((count + 1) * sizeof(vertex_t));
+
+    if(!start){
+        printf("NOT ENOUGH MEMORY\n");
+        exit(1);
+    }
+    start[0] = 0;
+    for(long c = 1; c < count; c++){ // first vertex whose preceding work reaches c * target
+
+        vertex_t lo = start[c - 1];
+        vertex_t hi = n;
+
+        while(lo < hi){
+            vertex_t mid = lo + (hi - lo) / 2;
+
+            if((long long)g->offsets[mid] + mid < c * target){
+                lo = mid + 1;
+            }
+            else{
+                hi = mid;
+            }
+        }
+        start[c] = lo;
+    }
+    start[count] = n;
+    *chunks = count;
+    return start;
+}
+
+int ColoringAlgorithm_threads(Graph* g){ // Returns the number of sweeps until no label changed
     
-    pthread_t threads[NUM_THREADS];
-    parm args[NUM_THREADS];
-    int n = g->vertices;
+    parm args[num_threads];
     bool changed = true;
+    int iterations = 0;
+    long chunks = 0;
+    vertex_t *chunk_start = NULL;
+    long *tasks = NULL;
+    Deque *deques = NULL;
+
+    prefetch_distance = resolvePrefetch(prefetch_option, g->vertices);
+
+    if(sched.steal){
+        chunk_start = stealChunks(g, &chunks);
+        tasks = malloc(chunks * sizeof(long));
+        deques = aligned_alloc(CACHE_LINE, num_threads * sizeof(Deque));
+
+        if(!tasks || !deques){
+            printf("NOT ENOUGH MEMORY\n");
+            exit(1);
+        }
+        for(long c = 0; c < chunks; c++){ // thread t owns a contiguous run and pops it from the back
+            tasks[c] = c;
+        }
+        for(int i = 0; i < num_threads; i++){
+            deques[i].tasks = tasks + chunks * i / num_threads;
+        }
+    }
+    sched.chunks = chunks;
+    sched.steals = 0;
+    sched.failed_steals = 0;
+    sched.busy = 0;
+    sched.idle = 0;
+
+    for(int i=0;i<num_threads;i++){
+        args[i].id = i;
+        args[i].g = g;
+        args[i].changed = &changed;
+        args[i].chunk_start = chunk_start;
+        args[i].deques = deques;
+        args[i].seed = 0x9e3779b9u * (i + 1);
+        args[i].steals = 0;
+        args[i].failed_steals = 0;
+    }
 
     while(changed){
         
         changed = false;
-        
-        for(int i=0;i<NUM_THREADS;i++){
-            args[i].id = i;
-            args[i].g = g;
-            args[i].changed = &changed;
-            pthread_create(&threads[i], NULL, worker, &args[i]);
+        iterations++;
+        TRACE(TraceIteration *it = traceIteration());
+
+        if(sched.steal){
+            for(int i = 0; i < num_threads; i++){
+                deques[i].top = 0;
+                deques[i].bottom = chunks * (i + 1) / num_threads - chunks * i / num_threads;
+            }
         }
+        double it_start = wallTime();
         
-        for(int i=0; i<NUM_THREADS;i++){
-            pthread_join(threads[i], NULL);
+        poolRun(sched.steal ? stealWorker : worker, args, sizeof(parm));
+
+        double it_time = wallTime() - it_start;
+
+        for(int i=0; i<num_threads;i++){
+            sched.busy += args[i].busy;
+            sched.idle += (it_time > args[i].busy) ? it_time - args[i].busy : 0;
+            TRACE(it->changed += args[i].changed_count; it->busy[i] = args[i].busy);
+        }
+        TRACE(it->time = it_time; it->edges = g->offsets[g->vertices]);
+        if(perf.per_iteration){
+            perfSample("iteration", iterations, (double)g->offsets[g->vertices]);
         }
     }
+    for(int i = 0; i < num_threads; i++){
+        sched.steals += args[i].steals;
+        sched.failed_steals += args[i].failed_steals;
+    }
+    free(chunk_start);
+    free(tasks);
+    free(deques);
+    return iterations;
 }
- 
 
+typedef struct GraphRun{ // One graph's results, printed in full for a single run or as one line in batch mode
+    Graph *g;
+    Components *c;
+    vertex_t largest;
+    int iterations;
+    int threads;                // sweep threads, --auto may use fewer than the pool has
+    double load_time;
+    double compute_time;
+    double stats_time;
+    double wall_time;           // load to statistics, a background cache write included
+    bool parsed;                // no cache yet, the input was parsed
+    bool seeded;                // --pipeline: the union-find gave the final labels, the sweeps were skipped
+    AutoChoice choice;          // --auto: the pre-analysis behind the chunk and thread count
+    Pipeline pipe;              // --pipeline: the union-find that ran alongside the parse
+    CacheWriter writer;         // --pipeline: the background cache write
+}GraphRun;
+
+bool use_pipeline = false; // --pipeline
+bool use_auto = false;     // --auto
+
+bool runGraph(const char* filename, GraphRun *r){ // Load from the cache or parse, then compute and collect statistics
 
-int main(int argc, char* argv[]){
-    if(argc < 2){
-        printf("opening: %s <matrix_file.mtx>\n", argv[0]);
-        return 1;
-    }
-    
     char bin_name[256];
-    snprintf(bin_name, sizeof(bin_name), "%s.bin", argv[1]);
+    struct timespec start, end;
+
+    snprintf(bin_name, sizeof(bin_name), "%s" BIN_SUFFIX, filename);
+    TRACE(memset(trace.phase, 0, sizeof(trace.phase)));
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    double wall_start = wallTime();
+    TRACE(double phase_start = traceTime());
     Graph* g = loadBinGraph(bin_name);
+    TRACE(if(g) trace.phase[PHASE_LOAD_CACHE] = traceTime() - phase_start);
+    memset(&r->writer, 0, sizeof(CacheWriter));
+    r->parsed = !g;
+    r->seeded = false;
     
     if(!g){
-        g = readMTX(argv[1]);
+        pipeline = use_pipeline ? &r->pipe : NULL;
+        g = readMTX(filename);
         
         if(!g){
-            return 1;
+            return false;
+        }
+        if(use_pipeline){
+            r->seeded = pipelineSeed(pipeline, g);
+            cacheWriteStart(&r->writer, g, bin_name);
+        }
+        else{
+            TRACE(phase_start = traceTime());
+            saveBinGraph(g, bin_name);
+            TRACE(trace.phase[PHASE_CACHE_WRITE] = traceTime() - phase_start);
         }
-        saveBinGraph(g, bin_name);
     }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    r->load_time = ((double)(end.tv_sec - start.tv_sec)) + ((double)(end.tv_nsec - start.tv_nsec)) / 1e9;
     
+    perfSample("load", -1, 0);
+
+    int pool_threads = num_threads;
+
+    if(use_auto && !r->seeded){ // the sweeps run on the picked share of the pool with the picked chunk
+        if(!autoAnalyze(filename, g, &r->choice)){
+            printf("NOT ENOUGH MEMORY\n");
+            cacheWriteWait(&r->writer);
+            freeGraph(g);
+            return false;
+        }
+        num_threads = (r->choice.threads < pool_threads) ? r->choice.threads : pool_threads;
+        steal_chunk = (long long)(r->choice.chunk * (1 + r->choice.avg_degree));
+    }
+    r->threads = num_threads;
+    TRACE(trace.threads = num_threads);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    r->iterations = r->seeded ? 0 : ColoringAlgorithm_threads(g);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    r->compute_time = ((double)(end.tv_sec - start.tv_sec)) + ((double)(end.tv_nsec - start.tv_nsec)) / 1e9;
+
+    perfSample("compute", -1, (double)r->iterations * g->offsets[g->vertices]);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    Components* c = computeComponents(g);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    perfSample("stats", -1, 0);
+    num_threads = pool_threads;
+    steal_chunk = 0;
+    r->stats_time = ((double)(end.tv_sec - start.tv_sec)) + ((double)(end.tv_nsec - start.tv_nsec)) / 1e9;
+
+    r->largest = 0;
+    for(vertex_t i = 0; i < c->count; i++){
+        if(c->sizes[i] > r->largest){
+            r->largest = c->sizes[i];
+        }
+    }
+    cacheWriteWait(&r->writer);
+    TRACE(if(use_pipeline && r->parsed) trace.phase[PHASE_CACHE_WRITE] = r->writer.seconds);
+    r->wall_time = wallTime() - wall_start;
+    r->g = g;
+    r->c = c;
+    TRACE(trace.phase[PHASE_COMPUTE] = r->compute_time);
+    TRACE(trace.phase[PHASE_STATS] = r->stats_time);
+    return true;
+}
+
+// Batch mode (--batch <manifest | directory>): every graph named in the manifest, one path per line with
+// '#' comments, or every graph input found in the directory, runs in this one process. The worker pool,
+// the spare graph arena and the heap's freed temporaries carry over from graph to graph, and while one
+// graph computes a reader thread pulls the next one's binary cache (or its input when it has none yet)
+// into the page cache.
+int runBatch(const char* path, bool save_labels, bool save_csv){
+
+    int count;
+    char **names = batchList(path, &count);
+
+    if(!names){
+        printf("Failed to read batch list %s\n", path);
+        return 1;
+    }
+    if(count == 0){
+        printf("No graphs found in %s\n", path);
+        free(names);
+        return 1;
+    }
+
+    arena_recycle = true;
+    mallopt(M_MMAP_THRESHOLD, 32 << 20); // keep freed temporaries in the heap instead of unmapping them
+    mallopt(M_TRIM_THRESHOLD, 1 << 30);
+
     struct timespec start, end;
+    Prefetch prefetch = {0};
+    int failed = 0;
+    long long total_edges = 0;
+    double load_time = 0, compute_time = 0, stats_time = 0;
+
     clock_gettime(CLOCK_MONOTONIC, &start);
-    ColoringAlgorithm_threads(g);
+
+    for(int i = 0; i < count; i++){
+
+        long long n, m;
+        const char* suffix = buildFor(names[i], &n, &m);
+
+        prefetchWait(&prefetch);
+        if(i + 1 < count){
+            prefetchStart(&prefetch, names[i + 1]);
+        }
+        if(suffix){
+            printf("%s: %lld vertices and up to %lld edges need the %s build, skipped\n", names[i], n, m, suffix);
+            failed++;
+            continue;
+        }
+
+        GraphRun r;
+
+        if(!runGraph(names[i], &r)){
+            if(wider_build){
+                printf("%s: needs the %s build, skipped\n", names[i], wider_build);
+                wider_build = NULL;
+            }
+            else{
+                printf("%s: failed to load\n", names[i]);
+            }
+            failed++;
+            continue;
+        }
+        if(use_auto && !r.seeded){
+            printf("%s: auto picked chunk %d, threads %d\n", names[i], r.choice.chunk, r.threads);
+        }
+        printf("%s: %lld vertices, %lld edges, %lld components, largest %lld, %d iterations, load %f s, compute %f s, stats %f s\n",
+               names[i], (long long)r.g->vertices, (long long)r.g->offsets[r.g->vertices], (long long)r.c->count,
+               (long long)r.largest, r.iterations, r.load_time, r.compute_time, r.stats_time);
+        fflush(stdout);
+
+        if(save_labels){
+            saveComponents(r.g, r.c, names[i], save_csv);
+        }
+        TRACE(traceWrite(names[i], "pthreads", (long long)r.g->vertices, (long long)r.g->offsets[r.g->vertices]));
+        total_edges += r.g->offsets[r.g->vertices];
+        load_time += r.load_time;
+        compute_time += r.compute_time;
+        stats_time += r.stats_time;
+        freeComponents(r.c);
+        freeGraph(r.g);
+    }
+    prefetchWait(&prefetch);
     clock_gettime(CLOCK_MONOTONIC, &end);
-    double time_taken = ((double)(end.tv_sec - start.tv_sec)) + ((double)(end.tv_nsec - start.tv_nsec)) / 1e9;
 
-    int num_components = 0;
-    
-    for(int i=0; i<g->vertices; i++){
-        
-        if(g->labels[i] == i){
-            num_components++;
+    double elapsed = ((double)(end.tv_sec - start.tv_sec)) + ((double)(end.tv_nsec - start.tv_nsec)) / 1e9;
+    int done = count - failed;
+
+    printf("Batch: %d graphs (%d failed) in %f seconds, %.2f graphs/s, %.0f edges/s\n",
+           done, failed, elapsed, elapsed > 0 ? done / elapsed : 0.0, elapsed > 0 ? total_edges / elapsed : 0.0);
+    printf("Batch time: load %f s, compute %f s, stats %f s, threads %d\n", load_time, compute_time, stats_time, num_threads);
+
+    for(int i = 0; i < count; i++){
+        free(names[i]);
+    }
+    free(names);
+    return failed ? 1 : 0;
+}
+
+int main(int argc, char* argv[]){
+    if(argc < 2 || (strcmp(argv[1], "--batch") == 0 && argc < 3)){
+        printf("opening: %s <matrix_file.mtx[.gz] | edge_list.txt[.gz] | archive.tar.gz> [--labels] [--csv] [--perf] [--perf-iter] [--sched steal|stride]\n"
+               "         [--prefetch auto|<distance>] [--pipeline] [--auto]\n", argv[0]);
+        printf("         %s --batch <manifest.txt | directory> [--labels] [--csv] [--perf] [--sched steal|stride] [--prefetch auto|<distance>] [--pipeline]\n"
+               "         [--auto]\n", argv[0]);
+        return 1;
+    }
+    const char* batch = (strcmp(argv[1], "--batch") == 0) ? argv[2] : NULL;
+
+    if(!batch){
+        selectBuild(argv);
+    }
+
+    const char* env_threads = getenv("CC_NUM_THREADS");
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+    if(env_threads && atoi(env_threads) > 0){
+        num_threads = atoi(env_threads);
+    }
+    else if(cpus > 0){
+        num_threads = (int)cpus;
+    }
+
+    bool save_labels = false;
+    bool save_csv = false;
+    bool use_perf = false;
+
+    for(int i = batch ? 3 : 2; i < argc; i++){
+        if(strcmp(argv[i], "--labels") == 0){
+            save_labels = true;
+        }
+        else if(strcmp(argv[i], "--csv") == 0){
+            save_labels = true;
+            save_csv = true;
+        }
+        else if(strcmp(argv[i], "--perf") == 0){
+            use_perf = true;
+        }
+        else if(strcmp(argv[i], "--perf-iter") == 0){
+            use_perf = true;
+            perf.per_iteration = true;
+        }
+        else if(strcmp(argv[i], "--sched") == 0 && i + 1 < argc){
+            i++;
+            if(strcmp(argv[i], "stride") == 0){
+                sched.steal = false;
+            }
+            else if(strcmp(argv[i], "steal") != 0){
+                printf("Unknown scheduler %s (steal, stride)\n", argv[i]);
+                return 1;
+            }
         }
-    } 
-    printf("Total Vertices: %d\n", g->vertices);
-    printf("Number of Connected Components: %d\n", num_components);
-    printf("time taken: %f seconds\n", time_taken);
+        else if(strcmp(argv[i], "--prefetch") == 0 && i + 1 < argc){
+            i++;
+            prefetch_option = (strcmp(argv[i], "auto") == 0) ? PREFETCH_AUTO : atoi(argv[i]);
+        }
+        else if(strcmp(argv[i], "--pipeline") == 0){
+            use_pipeline = true;
+        }
+        else if(strcmp(argv[i], "--auto") == 0){
+            use_auto = true;
+        }
+    }
+
+    poolStart(num_threads);
+    parallel.threads = num_threads;
+    parallel.run = poolParallel;
+
+    if(use_perf){
+        perfOpen();
+    }
+    if(batch){
+        int status = runBatch(batch, save_labels, save_csv);
+
+        perfClose();
+        return status;
+    }
+
+    GraphRun r;
+
+    if(!runGraph(argv[1], &r)){
+        if(wider_build){
+            execBuild(argv, wider_build);
+        }
+        return 1;
+    }
+    Graph* g = r.g;
+    Components* c = r.c;
+
+    printf("Total Vertices: %lld\n", (long long)g->vertices);
+    printf("Total Edges: %lld\n", (long long)g->offsets[g->vertices]);
+    printf("Graph arena: %.1f MB on %s pages\n", g->arena.used / 1048576.0, g->arena.backing);
+    printf("Threads: %d\n", r.threads);
+    if(prefetch_distance > 0){
+        printf("Label prefetch: %d edges ahead\n", prefetch_distance);
+    }
+    else{
+        printf("Label prefetch: off\n");
+    }
+    if(use_auto && !r.seeded){
+        autoReport(argv[1], &r.choice);
+        printf("Auto: chunk %d vertices, threads %d of %d\n", r.choice.chunk, r.threads, pool.size);
+    }
+    printf("Number of Connected Components: %lld\n", (long long)c->count);
+    printf("Largest Component: %lld vertices\n", (long long)r.largest);
+    printf("Iterations: %d\n", r.iterations);
+    if(sched.steal){
+        printf("Scheduler: steal, %ld chunks, %lld steals (%lld failed attempts), idle %.1f%% of thread time\n",
+               sched.chunks, sched.steals, sched.failed_steals, 100.0 * sched.idle / (sched.busy + sched.idle > 0 ? sched.busy + sched.idle : 1));
+    }
+    else{
+        printf("Scheduler: stride, idle %.1f%% of thread time\n", 100.0 * sched.idle / (sched.busy + sched.idle > 0 ? sched.busy + sched.idle : 1));
+    }
+    printf("Time taken: %f seconds\n", r.compute_time);
+    printf("Component statistics time: %f seconds\n", r.stats_time);
+    if(use_pipeline){
+        pipelineReport(&r.pipe, &r.writer, r.parsed);
+    }
+    printf("End to end: %f seconds (load %f, compute %f, stats %f)\n", r.wall_time, r.load_time, r.compute_time, r.stats_time);
+
+    if(save_labels){
+        saveComponents(g, c, argv[1], save_csv);
+    }
+    TRACE(traceWrite(argv[1], "pthreads", (long long)g->vertices, (long long)g->offsets[g->vertices]));
+    perfClose();
+    freeComponents(c);
     freeGraph(g);
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,693 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdint.h>
+#include <signal.h>
+#include <errno.h>
+#include <time.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// The two .labels layouts the backends write (LABELS_MAGIC and BIN_SUFFIX in ccgraph.h): the default and
+// _e64 builds store 32-bit ids next to <graph>.bin, the _v64 builds 64-bit ids next to <graph>.bin64.
+#define LABELS32_MAGIC "CCL1"
+#define LABELS32_SUFFIX ".bin"
+#define LABELS64_MAGIC "CCL2"
+#define LABELS64_SUFFIX ".bin64"
+#define MAX_CLIENTS 64
+#define MAX_BATCH 65536
+#define RELOAD_CHECK_MS 1000
+
+// Query opcodes. A request frame is a uint32 count followed by count Query
+// records; the reply is a uint32 count followed by count int64 results, so
+// ids and sizes of either labels width fit. Invalid arguments answer -1.
+#define OP_CONNECTED 1       // connected(a, b) -> 0 / 1
+#define OP_COMPONENT_OF 2    // component_of(a) -> compacted component id
+#define OP_COMPONENT_SIZE 3  // component_size(a) -> vertices in component a
+#define OP_NUM_COMPONENTS 4  // -> number of components
+#define OP_NUM_VERTICES 5    // -> number of vertices
+
+typedef struct Query{
+    uint32_t op;
+    uint32_t reserved;          // keeps a and b aligned, send 0
+    int64_t a;
+    int64_t b;
+}Query;
+
+typedef struct Snapshot{ // One mapped generation of <graph>.labels and the <graph>.bin header
+    void *labels_map;
+    size_t labels_size;
+    bool wide;                  // CCL2: 64-bit ids and sizes, CCL1: 32-bit
+    int64_t vertices;
+    long long num_edges;
+    int64_t count;
+    const void *comp;
+    const void *sizes;
+    struct timespec mtime;
+    ino_t ino;
+}Snapshot;
+
+typedef struct Client{ // Non-blocking connection: buffered request bytes and unsent replies
+    int fd;
+    char *buf;
+    size_t have;
+    char *out;
+    size_t out_have;
+    size_t out_sent;
+}Client;
+
+static volatile sig_atomic_t reload_requested = 0;
+static volatile sig_atomic_t stop_requested = 0;
+
+void onSignal(int sig){
+    if(sig == SIGHUP){
+        reload_requested = 1;
+    }
+    else{
+        stop_requested = 1;
+    }
+}
+
+int64_t readId(const void *p, bool wide){ // One id from a labels file or cache header of either width
+
+    if(wide){
+        int64_t v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+    int32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+int64_t entry(const Snapshot *s, const void *array, int64_t i){
+
+    return s->wide ? ((const int64_t*)array)[i] : ((const int32_t*)array)[i];
+}
+
+void *mapFile(const char *filename, size_t *size){
+
+    int fd = open(filename, O_RDONLY);
+
+    if(fd == -1){
+        return NULL;
+    }
+
+    struct stat st;
+
+    if(fstat(fd, &st) == -1 || st.st_size == 0){
+        close(fd);
+        return NULL;
+    }
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if(map == MAP_FAILED){
+        return NULL;
+    }
+    *size = st.st_size;
+    return map;
+}
+
+void freeSnapshot(Snapshot *s){
+
+    if(!s){
+        return;
+    }
+    if(s->labels_map){
+        munmap(s->labels_map, s->labels_size);
+    }
+    free(s);
+}
+
+Snapshot *loadSnapshot(const char *graph_name, const char *labels_name){
+
+    Snapshot *s = calloc(1, sizeof(Snapshot));
+
+    if(!s){
+        return NULL;
+    }
+
+    struct stat st;
+
+    if(stat(labels_name, &st) == -1){
+        free(s);
+        return NULL;
+    }
+    s->mtime = st.st_mtim;
+    s->ino = st.st_ino;
+    s->labels_map = mapFile(labels_name, &s->labels_size);
+
+    const char *l = s->labels_map;
+
+    if(!l || s->labels_size < 4 || (memcmp(l, LABELS32_MAGIC, 4) != 0 && memcmp(l, LABELS64_MAGIC, 4) != 0)){
+        printf("%s is not a labels file\n", labels_name);
+        freeSnapshot(s);
+        return NULL;
+    }
+    s->wide = memcmp(l, LABELS64_MAGIC, 4) == 0;
+
+    size_t id_size = s->wide ? sizeof(int64_t) : sizeof(int32_t);
+    char bin_name[256];
+
+    snprintf(bin_name, sizeof(bin_name), "%s%s", graph_name, s->wide ? LABELS64_SUFFIX : LABELS32_SUFFIX);
+
+    // Only the header of the graph cache is needed, read it instead of mapping the whole file
+    char header[sizeof(int64_t) + sizeof(long long)];
+    int bin_fd = open(bin_name, O_RDONLY);
+    bool header_ok = bin_fd != -1 && pread(bin_fd, header, id_size + sizeof(long long), 0) == (ssize_t)(id_size + sizeof(long long));
+
+    if(bin_fd != -1){
+        close(bin_fd);
+    }
+    if(!header_ok || s->labels_size < 4 + 2 * id_size){
+        printf("Failed to read %s and %s\n", bin_name, labels_name);
+        freeSnapshot(s);
+        return NULL;
+    }
+    s->vertices = readId(header, s->wide);
+    memcpy(&s->num_edges, header + id_size, sizeof(long long));
+
+    int64_t n = readId(l + 4, s->wide);
+
+    s->count = readId(l + 4 + id_size, s->wide);
+
+    const char *body = l + 4 + 2 * id_size;
+    size_t expected = 4 + (2 + 2 * (size_t)n + 2 * (size_t)s->count) * id_size;
+
+    if(n != s->vertices || s->count < 0 || s->count > n || s->labels_size < expected){
+        printf("Labels file %s does not match graph %s\n", labels_name, bin_name);
+        freeSnapshot(s);
+        return NULL;
+    }
+    s->comp = body + (size_t)n * id_size;
+    s->sizes = body + (2 * (size_t)n + s->count) * id_size;
+
+    madvise(s->labels_map, s->labels_size, MADV_WILLNEED);
+    return s;
+}
+
+bool sameVersion(const struct stat *st, ino_t ino, struct timespec mtime){ // The labels file is still the one (ino, mtime) names
+
+    return st->st_ino == ino && st->st_mtim.tv_sec == mtime.tv_sec && st->st_mtim.tv_nsec == mtime.tv_nsec;
+}
+
+int64_t answer(const Snapshot *s, const Query *q){
+
+    switch(q->op){
+        case OP_CONNECTED:
+            if(q->a < 0 || q->b < 0 || q->a >= s->vertices || q->b >= s->vertices){
+                return -1;
+            }
+            return entry(s, s->comp, q->a) == entry(s, s->comp, q->b);
+        case OP_COMPONENT_OF:
+            if(q->a < 0 || q->a >= s->vertices){
+                return -1;
+            }
+            return entry(s, s->comp, q->a);
+        case OP_COMPONENT_SIZE:
+            if(q->a < 0 || q->a >= s->count){
+                return -1;
+            }
+            return entry(s, s->sizes, q->a);
+        case OP_NUM_COMPONENTS:
+            return s->count;
+        case OP_NUM_VERTICES:
+            return s->vertices;
+        default:
+            return -1;
+    }
+}
+
+bool writeFull(int fd, const void *buf, size_t len){
+
+    const char *p = buf;
+
+    while(len > 0){
+
+        ssize_t w = write(fd, p, len);
+
+        if(w < 0 && errno == EINTR){
+            continue;
+        }
+        if(w <= 0){
+            return false;
+        }
+        p += w;
+        len -= w;
+    }
+    return true;
+}
+
+// Sends as much of a client's pending output as the socket takes without
+// blocking. Returns false if the client went away.
+bool flushClient(Client *c){
+
+    while(c->out_sent < c->out_have){
+
+        ssize_t w = write(c->fd, c->out + c->out_sent, c->out_have - c->out_sent);
+
+        if(w < 0 && errno == EINTR){
+            continue;
+        }
+        if(w < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)){
+            return true;
+        }
+        if(w <= 0){
+            return false;
+        }
+        c->out_sent += w;
+    }
+    c->out_have = 0;
+    c->out_sent = 0;
+    return true;
+}
+
+bool readFull(int fd, void *buf, size_t len){
+
+    char *p = buf;
+
+    while(len > 0){
+
+        ssize_t r = read(fd, p, len);
+
+        if(r < 0 && errno == EINTR){
+            continue;
+        }
+        if(r <= 0){
+            return false;
+        }
+        p += r;
+        len -= r;
+    }
+    return true;
+}
+
+// Answers the complete frames buffered for a client into its output buffer,
+// stopping when the next reply does not fit until the client drains it.
+// Returns the number of frames answered, or -1 if the client sent a
+// malformed frame or went away.
+int serveClient(Client *c, const Snapshot *s, size_t out_cap){
+
+    int frames = 0;
+
+    if(c->out_sent > 0){
+        memmove(c->out, c->out + c->out_sent, c->out_have - c->out_sent);
+        c->out_have -= c->out_sent;
+        c->out_sent = 0;
+    }
+
+    while(c->have >= sizeof(uint32_t)){
+
+        uint32_t count;
+        memcpy(&count, c->buf, sizeof(uint32_t));
+
+        if(count > MAX_BATCH){
+            return -1;
+        }
+
+        size_t frame = sizeof(uint32_t) + count * sizeof(Query);
+
+        size_t reply_size = sizeof(uint32_t) + count * sizeof(int64_t);
+
+        if(c->have < frame || c->out_have + reply_size > out_cap){
+            break;
+        }
+
+        const Query *queries = (const Query*)(c->buf + sizeof(uint32_t));
+        char *reply = c->out + c->out_have;
+
+        memcpy(reply, &count, sizeof(uint32_t));
+        for(uint32_t i = 0; i < count; i++){
+            int64_t result = answer(s, &queries[i]);
+            memcpy(reply + sizeof(uint32_t) + i * sizeof(int64_t), &result, sizeof(int64_t));
+        }
+        c->out_have += reply_size;
+
+        memmove(c->buf, c->buf + frame, c->have - frame);
+        c->have -= frame;
+        frames++;
+    }
+    return flushClient(c) ? frames : -1;
+}
+
+long long monotonicMs(){
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
+
+void closeClient(Client *c){
+
+    close(c->fd);
+    free(c->buf);
+    free(c->out);
+}
+
+int serve(const char *graph_name, const char *socket_path){
+
+    char labels_name[256];
+    snprintf(labels_name, sizeof(labels_name), "%s.labels", graph_name);
+
+    Snapshot *snap = loadSnapshot(graph_name, labels_name);
+
+    if(!snap){
+        printf("Failed to map %s and its graph cache (run a backend with --labels first)\n", labels_name);
+        return 1;
+    }
+    printf("Mapped %s: %lld vertices, %lld edges, %lld components, %d-bit ids\n", graph_name, (long long)snap->vertices, snap->num_edges,
+           (long long)snap->count, snap->wide ? 64 : 32);
+
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un addr;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socket_path, sizeof(addr.sun_path) - 1);
+    unlink(socket_path);
+
+    if(listen_fd == -1 || bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) == -1 || listen(listen_fd, MAX_CLIENTS) == -1){
+        printf("Failed to listen on %s: %s\n", socket_path, strerror(errno));
+        freeSnapshot(snap);
+        return 1;
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = onSignal;
+    sigaction(SIGHUP, &sa, NULL);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    printf("Listening on %s\n", socket_path);
+    fflush(stdout);
+
+    size_t buf_cap = sizeof(uint32_t) + MAX_BATCH * sizeof(Query);
+    size_t out_cap = sizeof(uint32_t) + MAX_BATCH * sizeof(int64_t);
+    Client clients[MAX_CLIENTS];
+    struct pollfd fds[MAX_CLIENTS + 1];
+    int num_clients = 0;
+    long long frames_served = 0;
+    long long next_check = monotonicMs() + RELOAD_CHECK_MS;
+    ino_t rejected_ino = 0;                 // the labels file the last reload gave up on, not retried until it changes
+    struct timespec rejected_mtime = {0, 0};
+
+    while(!stop_requested){
+
+        fds[0].fd = listen_fd;
+        fds[0].events = POLLIN;
+
+        // A client with unsent replies waits for POLLOUT; its input is only
+        // read while there is room to buffer it.
+        for(int i = 0; i < num_clients; i++){
+            fds[i + 1].fd = clients[i].fd;
+            fds[i + 1].events = (clients[i].have < buf_cap ? POLLIN : 0) | (clients[i].out_have > clients[i].out_sent ? POLLOUT : 0);
+        }
+
+        long long now = monotonicMs();
+        int timeout = next_check > now ? (int)(next_check - now) : 0;
+        int ready = poll(fds, num_clients + 1, timeout);
+
+        // The labels file is checked on its own timer, however busy the
+        // clients keep poll. Requests are answered on this thread, so swapping
+        // snapshots here never races with a lookup and no client is dropped.
+        now = monotonicMs();
+
+        if(reload_requested || now >= next_check){
+
+            struct stat seen;
+            bool present = stat(labels_name, &seen) == 0;
+            bool changed = present && !sameVersion(&seen, snap->ino, snap->mtime) && !sameVersion(&seen, rejected_ino, rejected_mtime);
+
+            if(reload_requested || changed){
+
+                Snapshot *next = loadSnapshot(graph_name, labels_name);
+
+                if(next){
+                    freeSnapshot(snap);
+                    snap = next;
+                    printf("Reloaded %s: %lld vertices, %lld components, %d-bit ids\n", graph_name, (long long)snap->vertices, (long long)snap->count,
+                           snap->wide ? 64 : 32);
+                }
+                else if(present){
+                    rejected_ino = seen.st_ino;
+                    rejected_mtime = seen.st_mtim;
+                    printf("Reload failed, still serving the previous cache until %s changes\n", labels_name);
+                }
+                else{
+                    printf("Reload failed, still serving the previous cache\n");
+                }
+                fflush(stdout);
+            }
+            reload_requested = 0;
+            next_check = now + RELOAD_CHECK_MS;
+        }
+        if(ready <= 0){
+            continue;
+        }
+
+        for(int i = num_clients - 1; i >= 0; i--){
+
+            short revents = fds[i + 1].revents;
+
+            if(!revents){
+                continue;
+            }
+
+            Client *c = &clients[i];
+            bool keep = !(revents & POLLERR);
+
+            if(keep && (revents & POLLOUT)){
+                keep = flushClient(c);
+            }
+            if(keep && (revents & (POLLIN | POLLHUP))){
+
+                ssize_t r = read(c->fd, c->buf + c->have, buf_cap - c->have);
+
+                if(r > 0){
+                    c->have += r;
+                }
+                else if(r == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)){
+                    keep = false;
+                }
+            }
+            if(keep){ // answer what was read, or what waited for the output to drain
+                int frames = serveClient(c, snap, out_cap);
+                keep = frames >= 0;
+                frames_served += keep ? frames : 0;
+            }
+            if(!keep){
+                closeClient(c);
+                clients[i] = clients[--num_clients];
+            }
+        }
+
+        if(fds[0].revents & POLLIN){
+
+            int fd = accept(listen_fd, NULL, NULL);
+
+            if(fd >= 0 && num_clients < MAX_CLIENTS && fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) != -1){
+
+                Client *c = &clients[num_clients];
+
+                c->fd = fd;
+                c->buf = malloc(buf_cap);
+                c->out = malloc(out_cap);
+                c->have = 0;
+                c->out_have = 0;
+                c->out_sent = 0;
+
+                if(c->buf && c->out){
+                    num_clients++;
+                }
+                else{
+                    closeClient(c);
+                }
+            }
+            else if(fd >= 0){
+                close(fd);
+            }
+        }
+    }
+
+    for(int i = 0; i < num_clients; i++){
+        closeClient(&clients[i]);
+    }
+    close(listen_fd);
+    unlink(socket_path);
+    freeSnapshot(snap);
+    printf("Served %lld frames\n", frames_served);
+    return 0;
+}
+
+int connectTo(const char *socket_path){
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un addr;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socket_path, sizeof(addr.sun_path) - 1);
+
+    if(fd == -1 || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) == -1){
+        printf("Failed to connect to %s: %s\n", socket_path, strerror(errno));
+        return -1;
+    }
+    return fd;
+}
+
+bool roundTrip(int fd, const Query *queries, uint32_t count, int64_t *results){
+
+    uint32_t reply_count;
+
+    if(!writeFull(fd, &count, sizeof(count)) || !writeFull(fd, queries, count * sizeof(Query))){
+        return false;
+    }
+    if(!readFull(fd, &reply_count, sizeof(reply_count)) || reply_count != count){
+        return false;
+    }
+    return readFull(fd, results, count * sizeof(int64_t));
+}
+
+int query(const char *socket_path, int argc, char *argv[]){
+
+    Query q = {0, 0, 0, 0};
+
+    if(argc >= 3 && strcmp(argv[0], "connected") == 0){
+        q.op = OP_CONNECTED;
+        q.a = atoll(argv[1]);
+        q.b = atoll(argv[2]);
+    }
+    else if(argc >= 2 && strcmp(argv[0], "component") == 0){
+        q.op = OP_COMPONENT_OF;
+        q.a = atoll(argv[1]);
+    }
+    else if(argc >= 2 && strcmp(argv[0], "size") == 0){
+        q.op = OP_COMPONENT_SIZE;
+        q.a = atoll(argv[1]);
+    }
+    else if(argc >= 1 && strcmp(argv[0], "count") == 0){
+        q.op = OP_NUM_COMPONENTS;
+    }
+    else{
+        printf("queries: connected <u> <v> | component <v> | size <c> | count\n");
+        return 1;
+    }
+
+    int fd = connectTo(socket_path);
+    int64_t result;
+
+    if(fd == -1){
+        return 1;
+    }
+    if(!roundTrip(fd, &q, 1, &result)){
+        printf("Query failed\n");
+        close(fd);
+        return 1;
+    }
+    printf("%lld\n", (long long)result);
+    close(fd);
+    return 0;
+}
+
+int bench(const char *socket_path, long long total, int batch){
+
+    int fd = connectTo(socket_path);
+
+    if(fd == -1){
+        return 1;
+    }
+
+    Query q = {OP_NUM_VERTICES, 0, 0, 0};
+    int64_t vertices;
+
+    if(!roundTrip(fd, &q, 1, &vertices) || vertices <= 0){
+        printf("Query failed\n");
+        close(fd);
+        return 1;
+    }
+
+    Query *queries = malloc(batch * sizeof(Query));
+    int64_t *results = malloc(batch * sizeof(int64_t));
+    unsigned int seed = 12345;
+    long long done = 0;
+    long long connected = 0;
+    double total_time = 0;
+    double max_time = 0;
+
+    while(done < total){
+
+        int count = (total - done < batch) ? (int)(total - done) : batch;
+
+        for(int i = 0; i < count; i++){
+            queries[i].op = OP_CONNECTED;
+            queries[i].reserved = 0;
+            queries[i].a = (((int64_t)rand_r(&seed) << 31) | rand_r(&seed)) % vertices; // two draws, for graphs past 2^31 vertices
+            queries[i].b = (((int64_t)rand_r(&seed) << 31) | rand_r(&seed)) % vertices;
+        }
+
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+
+        if(!roundTrip(fd, queries, count, results)){
+            printf("Query failed\n");
+            break;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        double t = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+        total_time += t;
+        if(t > max_time){
+            max_time = t;
+        }
+        for(int i = 0; i < count; i++){
+            connected += results[i] == 1;
+        }
+        done += count;
+    }
+
+    long long frames = (done + batch - 1) / batch;
+
+    printf("Queries: %lld in %lld frames of %d, %lld connected\n", done, frames, batch, connected);
+    if(frames > 0 && done > 0){
+        printf("Frame latency avg %f us, max %f us\n", total_time / frames * 1e6, max_time * 1e6);
+        printf("Per query %f us, %f queries/s\n", total_time / done * 1e6, done / total_time);
+    }
+    free(queries);
+    free(results);
+    close(fd);
+    return 0;
+}
+
+int main(int argc, char* argv[]){
+
+    if(argc >= 4 && strcmp(argv[1], "serve") == 0){
+        return serve(argv[2], argv[3]);
+    }
+    if(argc >= 4 && strcmp(argv[1], "query") == 0){
+        return query(argv[2], argc - 3, argv + 3);
+    }
+    if(argc >= 4 && strcmp(argv[1], "bench") == 0){
+        int batch = (argc > 4) ? atoi(argv[4]) : 1024;
+
+        if(batch <= 0 || batch > MAX_BATCH){
+            printf("batch must be in 1..%d\n", MAX_BATCH);
+            return 1;
+        }
+        return bench(argv[2], atoll(argv[3]), batch);
+    }
+    printf("opening: %s serve <matrix_file.mtx> <socket>\n", argv[0]);
+    printf("         %s query <socket> connected <u> <v> | component <v> | size <c> | count\n", argv[0]);
+    printf("         %s bench <socket> <num_queries> [batch]\n", argv[0]);
+    printf("serve maps <matrix_file.mtx>.labels (written by a backend with --labels) and reads the header of the\n");
+    printf(".bin or .bin64 cache matching its id width; send SIGHUP or replace the .labels file to reload\n");
+    return 1;
+}
@@ -0,0 +1,651 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <omp.h>
+#include "ccgraph.h"
+#include "ccinput.h"
+
+#define DEFAULT_BATCH 65536
+
+// Sliding-window connectivity over a stream of (u, v[, t]) edges.
+// Insertions go through a union-find whose successful unions mark the edge as
+// a spanning-forest (tree) edge. Expiring a non-tree edge never changes the
+// components; expiring a tree edge marks its component dirty, and after each
+// batch only the dirty components are recomputed from their live edges.
+// Input goes through ccinput: MatrixMarket or SNAP edge lists, plain or gzip'd,
+// or the matrix of a SuiteSparse .tar.gz. Edge lists grow the window's vertex
+// arrays as ids appear.
+
+typedef struct WEdge{
+    vertex_t u;
+    vertex_t v;
+    double t;
+    bool tree;
+}WEdge;
+
+typedef struct AdjList{ // Live (and lazily expired) edge ids incident to a vertex
+    long long *ids;
+    int size;
+    int cap;
+}AdjList;
+
+typedef struct Window{
+    vertex_t vertices;
+    vertex_t capacity;  // allocated vertices, edge lists grow it on demand
+    vertex_t *parent;
+    vertex_t *next;     // circular member list of every component
+    bool *dirty;
+    AdjList *adj;
+    vertex_t *dirty_roots;
+    vertex_t *members;  // dirty components' members, shared by all threads
+    vertex_t *offsets;  // where each dirty component's members start
+
+    WEdge *ring;        // edges in arrival order, slot = id & (cap - 1)
+    long long cap;
+    long long head;     // oldest live edge id
+    long long tail;     // next edge id
+
+    double window;
+    vertex_t num_components;
+    long long recomputes;
+    long long expired;
+}Window;
+
+// Makes room for vertices ids, each a new singleton component. Capacity
+// doubles, so an edge list that reveals its ids one by one regrows rarely.
+void growWindow(Window *w, vertex_t vertices){
+
+    if(vertices <= w->vertices){
+        return;
+    }
+    if(vertices > w->capacity){
+
+        vertex_t cap = w->capacity ? w->capacity : 1024;
+
+        while(cap < vertices){
+            cap = (cap > VERTEX_MAX / 2) ? VERTEX_MAX : 2 * cap;
+        }
+        w->parent = realloc(w->parent, cap * sizeof(vertex_t));
+        w->next = realloc(w->next, cap * sizeof(vertex_t));
+        w->dirty = realloc(w->dirty, cap * sizeof(bool));
+        w->adj = realloc(w->adj, cap * sizeof(AdjList));
+        w->dirty_roots = realloc(w->dirty_roots, cap * sizeof(vertex_t));
+        w->members = realloc(w->members, cap * sizeof(vertex_t));
+        w->offsets = realloc(w->offsets, ((size_t)cap + 1) * sizeof(vertex_t));
+
+        if(!w->parent || !w->next || !w->dirty || !w->adj || !w->dirty_roots || !w->members || !w->offsets){
+            printf("NOT ENOUGH MEMORY\n");
+            exit(1);
+        }
+        w->capacity = cap;
+    }
+
+    vertex_t first = w->vertices;
+
+    #pragma omp parallel for
+    for(vertex_t i = first; i < vertices; i++){
+        w->parent[i] = i;
+        w->next[i] = i;
+        w->dirty[i] = false;
+        w->adj[i] = (AdjList){NULL, 0, 0};
+    }
+    w->num_components += vertices - first;
+    w->vertices = vertices;
+}
+
+Window *createWindow(vertex_t vertices, double window){
+
+    Window *w = calloc(1, sizeof(Window));
+
+    if(!w){
+        return NULL;
+    }
+    w->cap = 1024;
+    w->ring = malloc(w->cap * sizeof(WEdge));
+    w->window = window;
+
+    if(!w->ring){
+        printf("NOT ENOUGH MEMORY\n");
+        exit(1);
+    }
+    growWindow(w, vertices);
+    return w;
+}
+
+void freeWindow(Window *w){
+
+    if(!w){
+        return;
+    }
+    for(vertex_t i = 0; i < w->vertices; i++){
+        free(w->adj[i].ids);
+    }
+    free(w->adj);
+    free(w->parent);
+    free(w->next);
+    free(w->dirty);
+    free(w->dirty_roots);
+    free(w->members);
+    free(w->offsets);
+    free(w->ring);
+    free(w);
+}
+
+static inline WEdge *edgeAt(Window *w, long long id){
+    return &w->ring[id & (w->cap - 1)];
+}
+
+vertex_t find(vertex_t *parent, vertex_t x){
+
+    while(parent[x] != x){
+        parent[x] = parent[parent[x]];
+        x = parent[x];
+    }
+    return x;
+}
+
+// Links the roots of a and b and splices their member lists. Returns false if
+// they were already connected.
+bool unite(Window *w, vertex_t a, vertex_t b){
+
+    vertex_t ra = find(w->parent, a);
+    vertex_t rb = find(w->parent, b);
+
+    if(ra == rb){
+        return false;
+    }
+    if(ra < rb){
+        w->parent[rb] = ra;
+    }
+    else{
+        w->parent[ra] = rb;
+    }
+    vertex_t tmp = w->next[ra];
+    w->next[ra] = w->next[rb];
+    w->next[rb] = tmp;
+    return true;
+}
+
+void adjPush(Window *w, vertex_t v, long long id){
+
+    AdjList *a = &w->adj[v];
+
+    if(a->size == a->cap){
+        int live = 0; // drop expired ids before growing
+
+        for(int i = 0; i < a->size; i++){
+            if(a->ids[i] >= w->head){
+                a->ids[live++] = a->ids[i];
+            }
+        }
+        a->size = live;
+
+        if(a->size == a->cap){
+            a->cap = a->cap ? 2 * a->cap : 4;
+            a->ids = realloc(a->ids, a->cap * sizeof(long long));
+
+            if(!a->ids){
+                printf("NOT ENOUGH MEMORY\n");
+                exit(1);
+            }
+        }
+    }
+    a->ids[a->size++] = id;
+}
+
+void growRing(Window *w){
+
+    long long new_cap = 2 * w->cap;
+    WEdge *ring = malloc(new_cap * sizeof(WEdge));
+
+    if(!ring){
+        printf("NOT ENOUGH MEMORY\n");
+        exit(1);
+    }
+    for(long long id = w->head; id < w->tail; id++){
+        ring[id & (new_cap - 1)] = *edgeAt(w, id);
+    }
+    free(w->ring);
+    w->ring = ring;
+    w->cap = new_cap;
+}
+
+void insertEdge(Window *w, vertex_t u, vertex_t v, double t){
+
+    if(w->tail - w->head == w->cap){
+        growRing(w);
+    }
+    long long id = w->tail++;
+    WEdge *e = edgeAt(w, id);
+
+    e->u = u;
+    e->v = v;
+    e->t = t;
+    e->tree = unite(w, u, v);
+
+    if(e->tree){
+        w->num_components--;
+    }
+    adjPush(w, u, id);
+    adjPush(w, v, id);
+}
+
+// Pops every edge older than now - window. Returns the number of components
+// that lost a tree edge and must be recomputed.
+vertex_t expireEdges(Window *w, double now){
+
+    vertex_t num_dirty = 0;
+
+    while(w->head < w->tail && edgeAt(w, w->head)->t <= now - w->window){
+
+        WEdge *e = edgeAt(w, w->head);
+
+        if(e->tree){
+            vertex_t r = find(w->parent, e->u);
+
+            if(!w->dirty[r]){
+                w->dirty[r] = true;
+                w->dirty_roots[num_dirty++] = r;
+            }
+        }
+        w->head++;
+        w->expired++;
+    }
+    return num_dirty;
+}
+
+#define SPLIT_MEMBERS 32768 // dirty components at least this large are relinked by all threads together
+
+// Re-unites the members of one dirty component from their live edges, dropping
+// expired ids from their adjacency as it goes. The members were reset to
+// singletons; returns the components they form now.
+vertex_t relinkComponent(Window *w, const vertex_t *members, vertex_t count){
+
+    vertex_t parts = count;
+
+    for(vertex_t i = 0; i < count; i++){
+
+        AdjList *a = &w->adj[members[i]];
+        int live = 0;
+
+        for(int k = 0; k < a->size; k++){
+
+            long long id = a->ids[k];
+
+            if(id < w->head){
+                continue;
+            }
+            a->ids[live++] = id;
+
+            WEdge *e = edgeAt(w, id);
+
+            if(e->u != members[i]){ // visit every edge once, from its u side
+                continue;
+            }
+            e->tree = unite(w, e->u, e->v);
+
+            if(e->tree){
+                parts--;
+            }
+        }
+        a->size = live;
+    }
+    return parts;
+}
+
+// Concurrent union-find for a large dirty component. Roots are linked with a
+// CAS, the larger id under the smaller as unite() does, so the forest stays
+// valid for the serial inserts of later batches.
+vertex_t findShared(vertex_t *parent, vertex_t x){
+
+    vertex_t p;
+
+    while((p = __atomic_load_n(&parent[x], __ATOMIC_RELAXED)) != x){
+
+        vertex_t gp = __atomic_load_n(&parent[p], __ATOMIC_RELAXED);
+
+        if(gp != p){ // path halving, x only ever moves closer to its root
+            __atomic_compare_exchange_n(&parent[x], &p, gp, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+        }
+        x = gp;
+    }
+    return x;
+}
+
+bool uniteShared(vertex_t *parent, vertex_t a, vertex_t b){
+
+    while(true){
+
+        vertex_t ra = findShared(parent, a);
+        vertex_t rb = findShared(parent, b);
+
+        if(ra == rb){
+            return false;
+        }
+        if(ra > rb){
+            vertex_t tmp = ra;
+            ra = rb;
+            rb = tmp;
+        }
+        if(__atomic_compare_exchange_n(&parent[rb], &rb, ra, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)){
+            return true;
+        }
+    }
+}
+
+// relinkComponent with the members split over the threads. The member lists
+// are rebuilt afterwards: every non-root pushes itself right after its root.
+vertex_t relinkShared(Window *w, const vertex_t *members, vertex_t count){
+
+    vertex_t merged = 0;
+
+    #pragma omp parallel for schedule(dynamic, 1024) reduction(+:merged)
+    for(vertex_t i = 0; i < count; i++){
+
+        AdjList *a = &w->adj[members[i]];
+        int live = 0;
+
+        for(int k = 0; k < a->size; k++){
+
+            long long id = a->ids[k];
+
+            if(id < w->head){
+                continue;
+            }
+            a->ids[live++] = id;
+
+            WEdge *e = edgeAt(w, id);
+
+            if(e->u != members[i]){
+                continue;
+            }
+            e->tree = uniteShared(w->parent, e->u, e->v);
+            merged += e->tree;
+        }
+        a->size = live;
+    }
+
+    #pragma omp parallel for schedule(static)
+    for(vertex_t i = 0; i < count; i++){
+
+        vertex_t v = members[i];
+        vertex_t r = findShared(w->parent, v);
+
+        if(r != v){
+            w->next[v] = __atomic_exchange_n(&w->next[r], v, __ATOMIC_RELAXED);
+        }
+    }
+    return count - merged;
+}
+
+// Rebuilds the dirty components from the live edges of their members.
+// Components are vertex-disjoint: their members are gathered into one n-sized
+// buffer at per-component offsets, small ones are relinked one per thread and
+// large ones by all threads in turn.
+vertex_t recomputeDirty(Window *w, vertex_t num_dirty){
+
+    vertex_t *dirty_roots = w->dirty_roots;
+    vertex_t *members = w->members;
+    vertex_t *offsets = w->offsets;
+
+    offsets[0] = 0;
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for(vertex_t i = 0; i < num_dirty; i++){
+
+        vertex_t count = 0;
+        vertex_t v = dirty_roots[i];
+
+        do{
+            count++;
+            v = w->next[v];
+        }while(v != dirty_roots[i]);
+
+        offsets[i + 1] = count;
+    }
+    for(vertex_t i = 0; i < num_dirty; i++){
+        offsets[i + 1] += offsets[i];
+    }
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for(vertex_t i = 0; i < num_dirty; i++){
+
+        vertex_t *m = members + offsets[i];
+        vertex_t v = dirty_roots[i];
+
+        do{
+            *m++ = v;
+            v = w->next[v];
+        }while(v != dirty_roots[i]);
+
+        w->dirty[dirty_roots[i]] = false;
+    }
+
+    #pragma omp parallel for schedule(static)
+    for(vertex_t k = 0; k < offsets[num_dirty]; k++){
+        w->parent[members[k]] = members[k];
+        w->next[members[k]] = members[k];
+    }
+
+    vertex_t new_components = 0;
+
+    #pragma omp parallel for schedule(dynamic, 1) reduction(+:new_components)
+    for(vertex_t i = 0; i < num_dirty; i++){
+
+        vertex_t count = offsets[i + 1] - offsets[i];
+
+        if(count < SPLIT_MEMBERS){
+            new_components += relinkComponent(w, members + offsets[i], count) - 1;
+        }
+    }
+    for(vertex_t i = 0; i < num_dirty; i++){
+
+        vertex_t count = offsets[i + 1] - offsets[i];
+
+        if(count >= SPLIT_MEMBERS){
+            new_components += relinkShared(w, members + offsets[i], count) - 1;
+        }
+    }
+    w->num_components += new_components;
+    w->recomputes += num_dirty;
+    return new_components;
+}
+
+int compareDouble(const void *a, const void *b){
+
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+
+    return (x > y) - (x < y);
+}
+
+// The timestamp after an edge's two ids, false when the line has none
+bool lineTime(const char *line, double *t){
+
+    const char *p = line;
+
+    for(int field = 0; field < 2; field++){
+        p += strspn(p, " \t");
+        p += strcspn(p, " \t\r\n");
+    }
+
+    char *end;
+    *t = strtod(p, &end);
+
+    return end != p;
+}
+
+int main(int argc, char* argv[]){
+
+    if(argc < 3){
+        printf("opening: %s <edges.mtx[.gz] | edge_list.txt[.gz]> <window> [batch_size] [--timestamps]\n", argv[0]);
+        printf("  without --timestamps the window is measured in edges (arrival order)\n");
+        return 1;
+    }
+
+    double window = atof(argv[2]);
+    int batch = DEFAULT_BATCH;
+    bool timestamps = false;
+
+    for(int i = 3; i < argc; i++){
+        if(strcmp(argv[i], "--timestamps") == 0){
+            timestamps = true;
+        }
+        else if(argv[i][0] != '-'){
+            batch = atoi(argv[i]);
+        }
+        else{
+            printf("Unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    if(window <= 0 || batch <= 0){
+        printf("window and batch_size must be positive\n");
+        return 1;
+    }
+
+    Input in;
+
+    if(!inputOpen(&in, argv[1])){ // plain, gzip'd or a SuiteSparse .tar.gz
+        printf("Failed to open %s\n", argv[1]);
+        return 1;
+    }
+
+    EdgeFormat fmt;
+    char line[1024];
+
+    edgeFormatInit(&fmt, argv[1]);
+
+    Window *w = createWindow(0, window);
+    vertex_t *bu = malloc(batch * sizeof(vertex_t));
+    vertex_t *bv = malloc(batch * sizeof(vertex_t));
+    double *bt = malloc(batch * sizeof(double));
+    long long max_batches = 1024;
+    double *latency = malloc(max_batches * sizeof(double));
+
+    if(!w || !bu || !bv || !bt || !latency){
+        printf("NOT ENOUGH MEMORY\n");
+        return 1;
+    }
+
+    long long ingested = 0;
+    long long num_batches = 0;
+    double now = 0;
+    double total_time = 0;
+    bool done = false;
+
+    while(!done){
+
+        int size = 0;
+
+        while(size < batch){
+
+            if(!inputGets(&in, line, sizeof(line))){
+                done = true;
+                break;
+            }
+
+            long long u, v;
+            int kind = edgeFormatLine(&fmt, line, &u, &v);
+
+            if(kind == LINE_BAD_SIZE){
+                printf("Failed to read header of %s\n", argv[1]);
+                return 1;
+            }
+            if(kind == LINE_SIZE){
+
+                long long n = (fmt.rows > fmt.cols) ? fmt.rows : fmt.cols;
+
+                if(n > VERTEX_MAX){
+                    printf("Graph has %lld vertices, more than vertex_t can hold\n", n);
+                    return 1;
+                }
+                growWindow(w, (vertex_t)n);
+                continue;
+            }
+            if(kind != LINE_EDGE || u == v){
+                continue;
+            }
+            if(!fmt.mtx){ // edge lists reveal their vertices as they go
+                if(u >= VERTEX_MAX || v >= VERTEX_MAX){
+                    continue;
+                }
+                growWindow(w, (vertex_t)((u > v) ? u : v) + 1);
+            }
+
+            double t;
+
+            if(!timestamps || !lineTime(line, &t)){
+                t = (double)(ingested + size);
+            }
+            if(t < now){ // out-of-order arrivals are treated as arriving now
+                t = now;
+            }
+            now = t;
+            bu[size] = (vertex_t)u;
+            bv[size] = (vertex_t)v;
+            bt[size] = t;
+            size++;
+        }
+
+        if(size == 0){
+            break;
+        }
+
+        double start_time = omp_get_wtime();
+
+        for(int i = 0; i < size; i++){
+            insertEdge(w, bu[i], bv[i], bt[i]);
+        }
+
+        vertex_t num_dirty = expireEdges(w, now);
+        vertex_t splits = recomputeDirty(w, num_dirty);
+
+        double elapsed = omp_get_wtime() - start_time;
+
+        if(num_batches == max_batches){
+            max_batches *= 2;
+            latency = realloc(latency, max_batches * sizeof(double));
+
+            if(!latency){
+                printf("NOT ENOUGH MEMORY\n");
+                return 1;
+            }
+        }
+        latency[num_batches++] = elapsed;
+        total_time += elapsed;
+        ingested += size;
+
+        printf("Batch %lld: +%d edges, live %lld, dirty %lld, splits %lld, components %lld, %f ms\n",
+               num_batches, size, w->tail - w->head, (long long)num_dirty, (long long)splits, (long long)w->num_components, elapsed * 1e3);
+    }
+
+    if(!inputClose(&in)){
+        printf("%s is truncated or corrupt\n", argv[1]);
+        return 1;
+    }
+
+    qsort(latency, num_batches, sizeof(double), compareDouble);
+
+    printf("Total Vertices: %lld\n", (long long)w->vertices);
+    printf("Edges ingested: %lld, expired: %lld, live: %lld\n", ingested, w->expired, w->tail - w->head);
+    printf("Components recomputed: %lld\n", w->recomputes);
+    printf("Number of Connected Components: %lld\n", (long long)w->num_components);
+
+    if(num_batches > 0){
+        printf("Batches: %lld, latency avg %f ms, p50 %f ms, p99 %f ms, max %f ms\n",
+               num_batches, total_time / num_batches * 1e3,
+               latency[num_batches / 2] * 1e3,
+               latency[(long long)((num_batches - 1) * 0.99)] * 1e3,
+               latency[num_batches - 1] * 1e3);
+        printf("Throughput: %f edges/s\n", total_time > 0 ? ingested / total_time : 0.0);
+    }
+    printf("Time taken: %f seconds\n", total_time);
+
+    free(bu); free(bv); free(bt);
+    free(latency);
+    freeWindow(w);
+    return 0;
+}
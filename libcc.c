@@ -0,0 +1,885 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <omp.h>
+#include "libcc.h"
+
+// OpenMP kernels behind the libcc API (libcc.h). ccopenmp is a driver over them; the other backends keep
+// their own copies for their runtimes. Built once per index width (make libcc.a), each object exporting
+// the width-suffixed names the header maps cc_components and friends to.
+
+typedef cc_vertex_t vertex_t;
+typedef cc_edge_t edge_t;
+
+#include "ccprefetch.h" // after the typedefs it uses
+
+typedef struct Run{ // One cc_components call
+    vertex_t n;
+    const edge_t *offsets;
+    const vertex_t *edges;
+    vertex_t *labels;
+    const cc_options *opt;
+    double *busy;               // per-thread scan time of the current round
+    int threads;
+    int prefetch;               // label prefetch distance in edges, 0 when off
+    vertex_t chunk;             // vertices per dynamically scheduled piece of a sweep
+}Run;
+
+static void reportIteration(Run *r, int iteration, long long changed, long long edges, double seconds){
+
+    if(!r->opt->on_iteration){
+        return;
+    }
+    cc_iteration it = {iteration, changed, edges, seconds, r->busy, r->threads};
+    r->opt->on_iteration(&it, r->opt->user);
+}
+
+#define SWEEP_CHUNK 512 // default cc_options.chunk
+
+static int propagate(Run *r, const vertex_t *active, vertex_t count, long long edges_per_round){ // Sweeps the active vertices (all when NULL) until no label changes, returns the rounds
+
+    const edge_t *offsets = r->offsets;
+    const vertex_t *edges = r->edges;
+    vertex_t *labels = r->labels;
+    bool prefetch = r->prefetch > 0;
+    vertex_t step = r->chunk;
+    long long changed = count > 0;
+    int iterations = 0;
+
+    while(changed){
+
+        changed = 0;
+        iterations++;
+        double it_start = omp_get_wtime();
+
+        #pragma omp parallel reduction(+:changed)
+        {
+            double busy_start = omp_get_wtime();
+
+            #pragma omp for schedule(dynamic, 1) nowait
+            for(vertex_t chunk = 0; chunk < count; chunk += step){
+
+                vertex_t chunk_end = (count - chunk < step) ? count : chunk + step;
+                Lookahead ahead = {r->offsets, r->edges, r->labels, active, chunk_end, 1};
+
+                lookaheadStart(&ahead, chunk, r->prefetch);
+
+                for(vertex_t i = chunk; i < chunk_end; i++){
+
+                    vertex_t v = active ? active[i] : i;
+
+                    for(edge_t k = offsets[v]; k < offsets[v + 1]; k++){
+
+                        vertex_t u = edges[k];
+
+                        if(prefetch){
+                            lookaheadStep(&ahead);
+                        }
+                        if(labels[v] > labels[u]){
+                            labels[v] = labels[u];
+                            changed++;
+                        }
+                    }
+                }
+            }
+            r->busy[omp_get_thread_num()] = omp_get_wtime() - busy_start;
+        }
+        reportIteration(r, iterations, changed, edges_per_round, omp_get_wtime() - it_start);
+    }
+    return iterations;
+}
+
+// Giant component peel (engine "peel"). A direction-optimizing BFS from the highest-degree vertex labels
+// the component holding it in a few level-synchronous steps, then label propagation runs only on the
+// vertices the BFS did not reach, none of which touches the giant. Top-down steps expand a frontier queue;
+// when the frontier's edges exceed the unexplored edges / PEEL_ALPHA a step goes bottom-up instead, every
+// unvisited vertex looking for a parent in a frontier byte map, and it returns to top-down once the
+// frontier shrinks below n / PEEL_BETA (Beamer's switching rule).
+#define PEEL_ALPHA 14
+#define PEEL_BETA 24
+#define PEEL_STAGE 1024 // per-thread staging for the next frontier queue
+
+static vertex_t collectVertices(const unsigned char *mark, unsigned char value, vertex_t n, vertex_t *out){ // Vertices with mark[v] == value, in increasing order
+
+    int blocks = omp_get_max_threads();
+    vertex_t start[blocks + 1];
+
+    start[0] = 0;
+
+    #pragma omp parallel for schedule(static, 1)
+    for(int b = 0; b < blocks; b++){
+        vertex_t count = 0;
+
+        for(vertex_t v = (long long)n * b / blocks; v < (long long)n * (b + 1) / blocks; v++){
+            count += (mark[v] == value);
+        }
+        start[b + 1] = count;
+    }
+    for(int b = 0; b < blocks; b++){
+        start[b + 1] += start[b];
+    }
+
+    #pragma omp parallel for schedule(static, 1)
+    for(int b = 0; b < blocks; b++){
+        vertex_t pos = start[b];
+
+        for(vertex_t v = (long long)n * b / blocks; v < (long long)n * (b + 1) / blocks; v++){
+            if(mark[v] == value){
+                out[pos++] = v;
+            }
+        }
+    }
+    return start[blocks];
+}
+
+static int peel(Run *r, cc_result *res){ // Returns the propagation rounds needed after the peel, -1 when out of memory
+
+    vertex_t n = r->n;
+    vertex_t *labels = r->labels;
+    const edge_t *offsets = r->offsets;
+    const vertex_t *edges = r->edges;
+    vertex_t root = 0;
+
+    #pragma omp parallel
+    {
+        vertex_t best = 0;
+
+        #pragma omp for nowait
+        for(vertex_t v = 0; v < n; v++){
+            if(offsets[v + 1] - offsets[v] > offsets[best + 1] - offsets[best]){
+                best = v;
+            }
+        }
+        #pragma omp critical
+        {
+            edge_t d = offsets[best + 1] - offsets[best];
+            edge_t d_root = offsets[root + 1] - offsets[root];
+
+            if(d > d_root || (d == d_root && best < root)){
+                root = best;
+            }
+        }
+    }
+
+    unsigned char *visited = calloc(n, 1);
+    unsigned char *front_map = calloc(n, 1);
+    unsigned char *next_map = calloc(n, 1);
+    vertex_t *queue = malloc(n * sizeof(vertex_t));
+    vertex_t *next = malloc(n * sizeof(vertex_t));
+
+    if(!visited || !front_map || !next_map || !queue || !next){
+        free(visited);
+        free(front_map);
+        free(next_map);
+        free(queue);
+        free(next);
+        return -1;
+    }
+
+    visited[root] = 1;
+    queue[0] = root;
+
+    vertex_t front_size = 1;
+    long long front_edges = offsets[root + 1] - offsets[root];
+    long long unexplored = (long long)offsets[n] - front_edges;
+    long long scanned = 0;
+    vertex_t reached = 1;
+    bool bottom_up = false; // which frontier is live: front_map when true, queue otherwise
+
+    while(front_size > 0){
+
+        res->bfs_levels++;
+
+        if(!bottom_up && front_edges > unexplored / PEEL_ALPHA){
+            #pragma omp parallel for
+            for(vertex_t i = 0; i < front_size; i++){
+                front_map[queue[i]] = 1;
+            }
+            bottom_up = true;
+        }
+        else if(bottom_up && front_size < n / PEEL_BETA){
+            collectVertices(front_map, 1, n, queue);
+            memset(front_map, 0, n);
+            bottom_up = false;
+        }
+
+        vertex_t next_size = 0;
+        long long next_edges = 0;
+
+        if(bottom_up){
+
+            res->bottom_up_levels++;
+
+            #pragma omp parallel for schedule(dynamic, 1024) reduction(+:next_size, next_edges, scanned)
+            for(vertex_t v = 0; v < n; v++){
+
+                if(visited[v]){
+                    continue;
+                }
+                for(edge_t k = offsets[v]; k < offsets[v + 1]; k++){
+                    scanned++;
+                    if(front_map[edges[k]]){
+                        visited[v] = 1;
+                        next_map[v] = 1;
+                        next_size++;
+                        next_edges += offsets[v + 1] - offsets[v];
+                        break;
+                    }
+                }
+            }
+            unsigned char *swap = front_map;
+            front_map = next_map;
+            next_map = swap;
+            memset(next_map, 0, n);
+        }
+        else{
+            #pragma omp parallel reduction(+:next_edges, scanned)
+            {
+                vertex_t stage[PEEL_STAGE];
+                int staged = 0;
+
+                #pragma omp for schedule(dynamic, 64) nowait
+                for(vertex_t i = 0; i < front_size; i++){
+
+                    vertex_t v = queue[i];
+
+                    for(edge_t k = offsets[v]; k < offsets[v + 1]; k++){
+
+                        vertex_t u = edges[k];
+                        scanned++;
+
+                        if(!visited[u] && __atomic_exchange_n(&visited[u], 1, __ATOMIC_RELAXED) == 0){
+                            stage[staged++] = u;
+                            next_edges += offsets[u + 1] - offsets[u];
+
+                            if(staged == PEEL_STAGE){
+                                vertex_t pos = __atomic_fetch_add(&next_size, staged, __ATOMIC_RELAXED);
+                                memcpy(next + pos, stage, staged * sizeof(vertex_t));
+                                staged = 0;
+                            }
+                        }
+                    }
+                }
+                vertex_t pos = __atomic_fetch_add(&next_size, staged, __ATOMIC_RELAXED);
+                memcpy(next + pos, stage, staged * sizeof(vertex_t));
+            }
+            vertex_t *swap = queue;
+            queue = next;
+            next = swap;
+        }
+        front_size = next_size;
+        front_edges = next_edges;
+        unexplored -= next_edges;
+        reached += next_size;
+    }
+
+    // The peeled component takes its minimum id, like propagation would give it
+    vertex_t min_id = n;
+
+    #pragma omp parallel for reduction(min:min_id)
+    for(vertex_t v = 0; v < n; v++){
+        if(visited[v] && v < min_id){
+            min_id = v;
+        }
+    }
+    #pragma omp parallel for
+    for(vertex_t v = 0; v < n; v++){
+        labels[v] = visited[v] ? min_id : v;
+    }
+
+    vertex_t rest = collectVertices(visited, 0, n, queue);
+    long long rest_edges = 0;
+
+    #pragma omp parallel for reduction(+:rest_edges)
+    for(vertex_t i = 0; i < rest; i++){
+        rest_edges += offsets[queue[i] + 1] - offsets[queue[i]];
+    }
+
+    int iterations = propagate(r, queue, rest, rest_edges);
+
+    res->peel_root = root;
+    res->peeled = reached;
+    res->edges_scanned = scanned + (double)iterations * rest_edges;
+
+    free(visited);
+    free(front_map);
+    free(next_map);
+    free(queue);
+    free(next);
+    return iterations;
+}
+
+// Cache-blocked propagation (engine "blocked"). The vertex range is tiled into blocks whose offsets, edges
+// and labels fit a thread's share of the last-level cache (half of LLC / threads unless block_bytes says
+// otherwise). Each global round hands blocks out dynamically; a block first sweeps all its edges, which
+// pulls in what other blocks found since the last round, and while that changes something it keeps
+// sweeping only its intra-block edges, now cache-resident, until it settles. Labels then cross block
+// boundaries once per round instead of once per sweep, and the rounds end when a first pass changes nothing.
+#define BLOCK_MIN_BYTES (256L << 10)
+#define BLOCK_DEFAULT_LLC (8L << 20)
+#define CACHE_LINE 64
+
+static long long blockBudget(const cc_options *opt, int threads){
+
+    if(opt->block_bytes > 0){
+        return opt->block_bytes;
+    }
+
+    long llc = sysconf(_SC_LEVEL3_CACHE_SIZE);
+
+    if(llc <= 0){
+        llc = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    }
+    if(llc <= 0){
+        llc = BLOCK_DEFAULT_LLC;
+    }
+    long long budget = llc / (2LL * threads);
+    return (budget < BLOCK_MIN_BYTES) ? BLOCK_MIN_BYTES : budget;
+}
+
+static vertex_t *cutBlocks(Run *r, long long budget, long long *count){ // Boundaries by binary search on the bytes before v
+
+    vertex_t n = r->n;
+    long long per_vertex = sizeof(edge_t) + sizeof(vertex_t);
+    long long total = (long long)r->offsets[n] * sizeof(vertex_t) + n * per_vertex;
+    long long blocks = (total + budget - 1) / budget;
+
+    if(blocks < 1){
+        blocks = 1;
+    }
+    vertex_t *start = malloc((blocks + 1) * sizeof(vertex_t));
+
+    if(!start){
+        return NULL;
+    }
+    start[0] = 0;
+    for(long long b = 1; b < blocks; b++){
+
+        vertex_t lo = start[b - 1];
+        vertex_t hi = n;
+
+        while(lo < hi){
+            vertex_t mid = lo + (hi - lo) / 2;
+
+            if((long long)r->offsets[mid] * sizeof(vertex_t) + mid * per_vertex < b * budget){
+                lo = mid + 1;
+            }
+            else{
+                hi = mid;
+            }
+        }
+        start[b] = lo;
+    }
+    start[blocks] = n;
+    *count = blocks;
+    return start;
+}
+
+static int blocked(Run *r, cc_result *res){ // Returns the global rounds, -1 when out of memory
+
+    vertex_t n = r->n;
+    const edge_t *offsets = r->offsets;
+    const vertex_t *edges = r->edges;
+    vertex_t *labels = r->labels;
+    long long blocks;
+    vertex_t *start = cutBlocks(r, blockBudget(r->opt, r->threads), &blocks);
+
+    if(!start){
+        return -1;
+    }
+
+    if(!r->opt->seeded){
+        #pragma omp parallel for
+        for(vertex_t i = 0; i < n; i++){
+            labels[i] = i;
+        }
+    }
+
+    long long cross = 0;
+
+    #pragma omp parallel for schedule(dynamic, 1) reduction(+:cross)
+    for(long long b = 0; b < blocks; b++){
+        for(edge_t k = offsets[start[b]]; k < offsets[start[b + 1]]; k++){
+            cross += (edges[k] < start[b] || edges[k] >= start[b + 1]);
+        }
+    }
+
+    bool prefetch = r->prefetch > 0;
+    double stream_bytes = (double)(n + 1) * sizeof(edge_t) + (double)offsets[n] * sizeof(vertex_t) + (double)n * sizeof(vertex_t);
+    long long changed = n > 0;
+    long long sweeps = 0;
+    int rounds = 0;
+
+    while(changed){
+
+        changed = 0;
+        rounds++;
+        double it_start = omp_get_wtime();
+        long long scanned = 0;
+
+        #pragma omp parallel reduction(+:changed, scanned, sweeps)
+        {
+            double busy_start = omp_get_wtime();
+
+            #pragma omp for schedule(dynamic, 1) nowait
+            for(long long b = 0; b < blocks; b++){
+
+                vertex_t lo = start[b];
+                vertex_t hi = start[b + 1];
+                long long block_changed = 0;
+                Lookahead ahead = {r->offsets, r->edges, r->labels, NULL, hi, 1};
+
+                lookaheadStart(&ahead, lo, r->prefetch);
+
+                for(vertex_t v = lo; v < hi; v++){
+                    for(edge_t k = offsets[v]; k < offsets[v + 1]; k++){
+
+                        vertex_t u = edges[k];
+
+                        if(prefetch){
+                            lookaheadStep(&ahead);
+                        }
+                        if(labels[v] > labels[u]){
+                            labels[v] = labels[u];
+                            block_changed++;
+                        }
+                    }
+                }
+                scanned += offsets[hi] - offsets[lo];
+                sweeps++;
+
+                while(block_changed){
+
+                    changed += block_changed;
+                    block_changed = 0;
+                    lookaheadStart(&ahead, lo, r->prefetch);
+
+                    for(vertex_t v = lo; v < hi; v++){
+                        for(edge_t k = offsets[v]; k < offsets[v + 1]; k++){
+
+                            vertex_t u = edges[k];
+
+                            if(prefetch){
+                                lookaheadStep(&ahead);
+                            }
+                            if(u >= lo && u < hi && labels[v] > labels[u]){
+                                labels[v] = labels[u];
+                                block_changed++;
+                            }
+                        }
+                    }
+                    scanned += offsets[hi] - offsets[lo];
+                    sweeps++;
+                }
+            }
+            r->busy[omp_get_thread_num()] = omp_get_wtime() - busy_start;
+        }
+        reportIteration(r, rounds, changed, scanned, omp_get_wtime() - it_start);
+        res->edges_scanned += scanned;
+    }
+
+    res->blocks = blocks;
+    res->block_sweeps = sweeps;
+    res->dram_bytes = rounds * (stream_bytes + (double)cross * CACHE_LINE);
+    free(start);
+    return rounds;
+}
+
+// Recursive contraction (engine "contract"). Propagation rescans every edge each round, including the
+// ones whose endpoints already agree. Here a level runs up to CONTRACT_ROUNDS cheap hooking rounds (each
+// vertex hooks its parent under the smallest label among its neighbours, then one shortcut pass), flattens
+// the forest onto its roots and contracts every tree into a supervertex of a quotient CSR holding only the
+// edges between trees, deduplicated. Levels recurse until no edge is left and the labels are expanded back
+// on the way up. A root is the smallest vertex of its tree and roots are numbered in increasing order, so
+// the smallest supervertex of a component expands to its smallest vertex, as with the other engines.
+#define CONTRACT_ROUNDS 2
+
+static inline void atomicMin(vertex_t *p, vertex_t value){
+
+    vertex_t current = __atomic_load_n(p, __ATOMIC_RELAXED);
+
+    while(value < current && !__atomic_compare_exchange_n(p, &current, value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+static int compareVertex(const void *a, const void *b){
+
+    vertex_t x = *(const vertex_t*)a;
+    vertex_t y = *(const vertex_t*)b;
+    return (x > y) - (x < y);
+}
+
+static int hookRounds(Run *r, vertex_t n, const edge_t *offsets, const vertex_t *edges, vertex_t *labels, bool *settled){ // Leaves labels[v] = root of v's tree, returns the hooking rounds
+
+    vertex_t chunk = r->chunk;
+    int rounds = 0;
+    long long changed = 1;
+
+    while(changed && rounds < CONTRACT_ROUNDS){
+
+        changed = 0;
+        rounds++;
+
+        #pragma omp parallel reduction(+:changed)
+        {
+            double busy_start = omp_get_wtime();
+
+            #pragma omp for schedule(dynamic, chunk) nowait
+            for(vertex_t v = 0; v < n; v++){
+
+                vertex_t parent = labels[v];
+                vertex_t smallest = parent;
+
+                for(edge_t k = offsets[v]; k < offsets[v + 1]; k++){
+                    if(labels[edges[k]] < smallest){
+                        smallest = labels[edges[k]];
+                    }
+                }
+                if(smallest < parent){
+                    atomicMin(&labels[parent], smallest);
+                    atomicMin(&labels[v], smallest);
+                    changed++;
+                }
+            }
+            r->busy[omp_get_thread_num()] += omp_get_wtime() - busy_start;
+        }
+
+        #pragma omp parallel for
+        for(vertex_t v = 0; v < n; v++){
+            labels[v] = labels[labels[v]];
+        }
+    }
+
+    // labels[v] <= v throughout, so parents form a forest and following them ends at the tree's minimum
+    #pragma omp parallel for schedule(dynamic, chunk)
+    for(vertex_t v = 0; v < n; v++){
+
+        vertex_t root = labels[v];
+
+        while(labels[root] != root){
+            root = labels[root];
+        }
+        labels[v] = root;
+    }
+    *settled = (changed == 0); // a round that lowers nothing means every edge is internal to a tree
+    return rounds;
+}
+
+// Quotient CSR over the supervertices: id[root] numbers the roots, labels[v] is v's root. Edges whose
+// endpoints share a root are dropped and every row is sorted and deduplicated. Returns false when out of memory.
+static bool contractEdges(vertex_t n, vertex_t chunk, const edge_t *offsets, const vertex_t *edges, const vertex_t *labels,
+                          const vertex_t *id, vertex_t supervertices, edge_t **out_offsets, vertex_t **out_edges){
+
+    edge_t *start = calloc(supervertices + 1, sizeof(edge_t));
+    edge_t *degree = malloc(supervertices * sizeof(edge_t) + 1);
+
+    if(!start || !degree){
+        free(start);
+        free(degree);
+        return false;
+    }
+
+    #pragma omp parallel for schedule(dynamic, chunk)
+    for(vertex_t v = 0; v < n; v++){
+
+        edge_t cross = 0;
+
+        for(edge_t k = offsets[v]; k < offsets[v + 1]; k++){
+            cross += (labels[edges[k]] != labels[v]);
+        }
+        if(cross){
+            #pragma omp atomic
+            start[id[labels[v]] + 1] += cross;
+        }
+    }
+    for(vertex_t s = 0; s < supervertices; s++){
+        start[s + 1] += start[s];
+        degree[s] = start[s];
+    }
+
+    vertex_t *scattered = malloc((size_t)start[supervertices] * sizeof(vertex_t) + 1);
+
+    if(!scattered){
+        free(start);
+        free(degree);
+        return false;
+    }
+
+    #pragma omp parallel for schedule(dynamic, chunk)
+    for(vertex_t v = 0; v < n; v++){
+
+        vertex_t s = id[labels[v]];
+
+        for(edge_t k = offsets[v]; k < offsets[v + 1]; k++){
+
+            vertex_t root = labels[edges[k]];
+
+            if(root != labels[v]){
+                edge_t slot = __atomic_fetch_add(&degree[s], 1, __ATOMIC_RELAXED);
+                scattered[slot] = id[root];
+            }
+        }
+    }
+
+    #pragma omp parallel for schedule(dynamic, 64)
+    for(vertex_t s = 0; s < supervertices; s++){
+
+        vertex_t *row = scattered + start[s];
+        edge_t count = start[s + 1] - start[s];
+        edge_t unique = 0;
+
+        qsort(row, count, sizeof(vertex_t), compareVertex);
+
+        for(edge_t k = 0; k < count; k++){
+            if(unique == 0 || row[k] != row[unique - 1]){
+                row[unique++] = row[k];
+            }
+        }
+        degree[s] = unique;
+    }
+
+    edge_t *quotient_offsets = malloc((supervertices + 1) * sizeof(edge_t));
+
+    if(!quotient_offsets){
+        free(start);
+        free(degree);
+        free(scattered);
+        return false;
+    }
+    quotient_offsets[0] = 0;
+
+    for(vertex_t s = 0; s < supervertices; s++){
+        quotient_offsets[s + 1] = quotient_offsets[s] + degree[s];
+    }
+
+    vertex_t *quotient_edges = malloc((size_t)quotient_offsets[supervertices] * sizeof(vertex_t) + 1);
+
+    if(!quotient_edges){
+        free(start);
+        free(degree);
+        free(scattered);
+        free(quotient_offsets);
+        return false;
+    }
+
+    #pragma omp parallel for schedule(dynamic, chunk)
+    for(vertex_t s = 0; s < supervertices; s++){
+        memcpy(quotient_edges + quotient_offsets[s], scattered + start[s], degree[s] * sizeof(vertex_t));
+    }
+
+    free(start);
+    free(degree);
+    free(scattered);
+    *out_offsets = quotient_offsets;
+    *out_edges = quotient_edges;
+    return true;
+}
+
+static int contractLevel(Run *r, vertex_t n, const edge_t *offsets, const vertex_t *edges, vertex_t *labels,
+                         bool seeded, int level, cc_result *res){ // Labels one level and the ones below it, -1 when out of memory
+
+    double it_start = omp_get_wtime();
+
+    if(!seeded){
+        #pragma omp parallel for
+        for(vertex_t v = 0; v < n; v++){
+            labels[v] = v;
+        }
+    }
+    for(int t = 0; t < r->threads; t++){
+        r->busy[t] = 0;
+    }
+
+    bool settled;
+    int rounds = hookRounds(r, n, offsets, edges, labels, &settled);
+
+    res->iterations += rounds;
+    res->levels = level + 1;
+
+    if(settled){
+        res->edges_scanned += (double)rounds * offsets[n];
+        reportIteration(r, level + 1, 0, (long long)rounds * offsets[n], omp_get_wtime() - it_start);
+        return 0;
+    }
+
+    long long scanned = (long long)(rounds + 1) * offsets[n];
+
+    unsigned char *is_root = malloc(n + 1);
+    vertex_t *roots = malloc(n * sizeof(vertex_t) + 1);
+    vertex_t *id = malloc(n * sizeof(vertex_t) + 1);
+
+    if(!is_root || !roots || !id){
+        free(is_root);
+        free(roots);
+        free(id);
+        return -1;
+    }
+
+    #pragma omp parallel for
+    for(vertex_t v = 0; v < n; v++){
+        is_root[v] = (labels[v] == v);
+    }
+    vertex_t supervertices = collectVertices(is_root, 1, n, roots);
+    free(is_root);
+
+    #pragma omp parallel for
+    for(vertex_t s = 0; s < supervertices; s++){
+        id[roots[s]] = s;
+    }
+
+    edge_t *quotient_offsets;
+    vertex_t *quotient_edges;
+
+    if(!contractEdges(n, r->chunk, offsets, edges, labels, id, supervertices, &quotient_offsets, &quotient_edges)){
+        free(roots);
+        free(id);
+        return -1;
+    }
+
+    edge_t remaining = quotient_offsets[supervertices];
+
+    res->edges_scanned += scanned;
+    reportIteration(r, level + 1, n - supervertices, scanned, omp_get_wtime() - it_start);
+
+    int status = 0;
+
+    if(remaining > 0){
+
+        vertex_t *quotient_labels = malloc(supervertices * sizeof(vertex_t));
+
+        status = quotient_labels ? contractLevel(r, supervertices, quotient_offsets, quotient_edges, quotient_labels, false, level + 1, res) : -1;
+
+        if(status == 0){
+            #pragma omp parallel for
+            for(vertex_t v = 0; v < n; v++){
+                labels[v] = roots[quotient_labels[id[labels[v]]]];
+            }
+        }
+        free(quotient_labels);
+    }
+
+    free(quotient_offsets);
+    free(quotient_edges);
+    free(roots);
+    free(id);
+    return status;
+}
+
+void cc_default_options(cc_options *opt){
+    memset(opt, 0, sizeof(cc_options));
+    opt->engine = "lp";
+    opt->prefetch = CC_PREFETCH_AUTO;
+}
+
+int cc_components(vertex_t vertices, const edge_t *offsets, const vertex_t *edges, vertex_t *labels,
+                  const cc_options *opt, cc_result *result){
+
+    cc_options defaults;
+    cc_result local;
+
+    if(!opt){
+        cc_default_options(&defaults);
+        opt = &defaults;
+    }
+    if(!result){
+        result = &local;
+    }
+    memset(result, 0, sizeof(cc_result));
+
+    if(vertices < 0 || (vertices > 0 && (!offsets || !labels || (offsets[vertices] > 0 && !edges)))){
+        return CC_EINVAL;
+    }
+
+    bool use_peel = false;
+    bool use_blocked = false;
+    bool use_contract = false;
+
+    if(opt->engine && strcmp(opt->engine, "peel") == 0){
+        use_peel = true;
+    }
+    else if(opt->engine && strcmp(opt->engine, "blocked") == 0){
+        use_blocked = true;
+    }
+    else if(opt->engine && strcmp(opt->engine, "contract") == 0){
+        use_contract = true;
+    }
+    else if(opt->engine && strcmp(opt->engine, "lp") != 0){
+        return CC_EENGINE;
+    }
+
+    int saved_threads = omp_get_max_threads();
+
+    if(opt->threads > 0){
+        omp_set_num_threads(opt->threads);
+    }
+
+    Run r = {vertices, offsets, edges, labels, opt, NULL, omp_get_max_threads(), resolvePrefetch(opt->prefetch, vertices),
+             opt->chunk > 0 ? opt->chunk : SWEEP_CHUNK};
+    r.busy = calloc(r.threads, sizeof(double));
+
+    if(!r.busy){
+        omp_set_num_threads(saved_threads);
+        return CC_ENOMEM;
+    }
+
+    double start = omp_get_wtime();
+    int status = CC_OK;
+
+    result->prefetch = r.prefetch;
+    result->threads = r.threads;
+    result->chunk = r.chunk;
+
+    if(use_peel && vertices > 0){
+        result->iterations = peel(&r, result);
+        status = (result->iterations < 0) ? CC_ENOMEM : CC_OK;
+    }
+    else if(use_blocked){
+        result->iterations = blocked(&r, result);
+        status = (result->iterations < 0) ? CC_ENOMEM : CC_OK;
+    }
+    else if(use_contract){
+        status = (vertices > 0 && contractLevel(&r, vertices, offsets, edges, labels, opt->seeded, 0, result) < 0) ? CC_ENOMEM : CC_OK;
+    }
+    else{
+        if(!opt->seeded){
+            #pragma omp parallel for
+            for(vertex_t i = 0; i < vertices; i++){
+                labels[i] = i;
+            }
+        }
+        result->iterations = propagate(&r, NULL, vertices, vertices > 0 ? (long long)offsets[vertices] : 0);
+        result->edges_scanned = vertices > 0 ? (double)result->iterations * offsets[vertices] : 0;
+    }
+    result->seconds = omp_get_wtime() - start;
+
+    if(status == CC_OK){
+        vertex_t components = 0;
+
+        #pragma omp parallel for reduction(+:components)
+        for(vertex_t v = 0; v < vertices; v++){
+            components += (labels[v] == v);
+        }
+        result->components = components;
+    }
+
+    free(r.busy);
+    omp_set_num_threads(saved_threads);
+    return status;
+}
+
+const char *cc_strerror(int code){
+
+    switch(code){
+        case CC_OK:
+            return "success";
+        case CC_EINVAL:
+            return "invalid graph arguments";
+        case CC_ENOMEM:
+            return "not enough memory";
+        case CC_EENGINE:
+            return "unknown engine (lp, peel, blocked, contract)";
+    }
+    return "unknown error";
+}
@@ -0,0 +1,100 @@
+#ifndef LIBCC_H
+#define LIBCC_H
+
+// libcc: connected components of an in-memory CSR graph owned by the caller. Nothing is copied: the
+// kernels read offsets and edges in place and write labels[v] = the smallest vertex id in v's component
+// into the caller's buffer. The adjacency must be symmetric (every edge stored in both directions, as in
+// the .bin cache) with offsets[vertices] entries in edges.
+//
+// Index widths follow the executables and are chosen when including this header: the default is 32-bit
+// vertex ids and edge offsets, -DCC_EDGE_BITS=64 gives 64-bit offsets and -DCC_VERTEX_BITS=64 gives
+// 64-bit ids and offsets. libcc.a and libcc.so carry all three; each width has its own symbol names, so
+// a header/library mismatch fails to link instead of misreading the arrays.
+
+#include <stdint.h>
+
+#ifndef CC_VERTEX_BITS
+#define CC_VERTEX_BITS 32
+#endif
+#ifndef CC_EDGE_BITS
+#define CC_EDGE_BITS CC_VERTEX_BITS
+#endif
+
+#if CC_VERTEX_BITS == 64
+typedef int64_t cc_vertex_t;
+#else
+typedef int32_t cc_vertex_t;
+#endif
+
+#if CC_EDGE_BITS == 64
+typedef int64_t cc_edge_t;
+#else
+typedef uint32_t cc_edge_t;
+#endif
+
+#if CC_VERTEX_BITS == 64
+#define cc_default_options cc_default_options_v64
+#define cc_components cc_components_v64
+#define cc_strerror cc_strerror_v64
+#elif CC_EDGE_BITS == 64
+#define cc_default_options cc_default_options_e64
+#define cc_components cc_components_e64
+#define cc_strerror cc_strerror_e64
+#endif
+
+enum { CC_OK = 0, CC_EINVAL, CC_ENOMEM, CC_EENGINE };
+
+#define CC_PREFETCH_AUTO (-1)   // cc_options.prefetch: on when the labels outgrow L2, off when they fit
+#define CC_PREFETCH_DISTANCE 16 // edges the neighbour-label prefetch runs ahead of a sweep when on
+
+typedef struct cc_iteration{ // Passed to on_iteration after every propagation round (engine "contract": every level)
+    int iteration;
+    long long changed;          // labels lowered in this round (engine "contract": vertices merged into supervertices)
+    long long edges;            // edges scanned
+    double seconds;
+    const double *busy;         // seconds each thread spent scanning, threads entries
+    int threads;
+}cc_iteration;
+
+typedef struct cc_options{
+    const char *engine;         // "lp" (label propagation, the default), "peel" (BFS the giant component
+                                // first), "blocked" (cache-sized vertex blocks settled locally each round) or
+                                // "contract" (hook, contract into a quotient graph and recurse)
+    int threads;                // 0 keeps the OpenMP default (OMP_NUM_THREADS)
+    void (*on_iteration)(const cc_iteration *it, void *user);
+    void *user;
+    long long block_bytes;      // engine "blocked": offsets, edges and labels per block, 0 sizes them from the LLC
+    int prefetch;               // edges the labels[edges[k]] prefetch runs ahead of a sweep, 0 turns it off,
+                                // CC_PREFETCH_AUTO (the default) picks CC_PREFETCH_DISTANCE or 0
+    int seeded;                 // engines "lp", "blocked" and "contract": labels[v] already names a vertex of v's component
+                                // no larger than v (e.g. a union-find root), propagation starts from there
+    cc_vertex_t chunk;          // vertices per dynamically scheduled piece of a sweep, 0 keeps the default (512)
+}cc_options;
+
+typedef struct cc_result{
+    cc_vertex_t components;
+    int iterations;             // propagation rounds (engine "contract": hooking rounds over all levels)
+    double seconds;
+    double edges_scanned;
+    cc_vertex_t peel_root;      // engine "peel" only: BFS root, vertices it labelled and its levels
+    cc_vertex_t peeled;
+    int bfs_levels;
+    int bottom_up_levels;
+    long long blocks;           // engine "blocked" only: blocks, block sweeps over all rounds and the modelled
+    long long block_sweeps;     // DRAM traffic (each block streamed once per round, cross-block label reads
+    double dram_bytes;          // as cache-line misses)
+    int prefetch;               // label prefetch distance used, 0 when off
+    int levels;                 // engine "contract" only: graphs hooked and contracted, the input included
+    int threads;                // threads and sweep chunk used
+    cc_vertex_t chunk;
+}cc_result;
+
+void cc_default_options(cc_options *opt);
+
+// Returns CC_OK or an error code; result may be NULL.
+int cc_components(cc_vertex_t vertices, const cc_edge_t *offsets, const cc_vertex_t *edges, cc_vertex_t *labels,
+                  const cc_options *opt, cc_result *result);
+
+const char *cc_strerror(int code);
+
+#endif